@@ -1,8 +1,10 @@
 ﻿using IGESWrapper;
 using System;
 using System.IO;
+using System.Threading;
 using System.Windows;
 using System.Windows.Input;
+using System.Windows.Media;
 using System.Windows.Media.Imaging;
 
 namespace ProSMARTAPP {
@@ -14,23 +16,94 @@ namespace ProSMARTAPP {
       const double ZoomFactor = 1.1; // Zoom scale factor
       const double MinZoom = 0.5;    // Minimum zoom level
       const double MaxZoom = 5.0;    // Maximum zoom level
+      const int FrameWidth = 800, FrameHeight = 600; // Size of the camera frames
+      bool mHasViewFrame = false;    // The image shows a frame from the persistent view
+      Point mPressPosition;          // Where the left button went down, to tell a click from a drag
+
+      // Every call into the handler holds this gate. Background work keeps it for the whole
+      // operation; the persistent view is driven from the UI thread and skips a frame while
+      // the gate is taken instead of waiting for a union.
+      readonly SemaphoreSlim mHandlerGate = new (1, 1);
+
+      // Snapshot of the last session, restored on the next start
+      static readonly string SessionPath = Path.Combine (
+         Environment.GetFolderPath (Environment.SpecialFolder.LocalApplicationData), "ProSMART", "session.psms");
 
       public MainWindow () {
          InitializeComponent ();
+         Loaded += (s, e) => RestoreLastSession ();
+      }
+
+      // Run handler work on a pool thread while holding the gate
+      async Task RunOnHandlerAsync (Action work) {
+         await mHandlerGate.WaitAsync ();
+         try {
+            await Task.Run (work);
+         } finally {
+            mHandlerGate.Release ();
+         }
+      }
+
+      // Run handler work on the UI thread once the gate is free
+      async Task<T> WithHandlerAsync<T> (Func<T> work) {
+         await mHandlerGate.WaitAsync ();
+         try {
+            return work ();
+         } finally {
+            mHandlerGate.Release ();
+         }
+      }
+
+      // Run a view update on the UI thread if the handler is free; false when it is busy
+      bool TryWithHandler (Action work) {
+         if (!mHandlerGate.Wait (0)) return false;
+         try {
+            work ();
+            return true;
+         } finally {
+            mHandlerGate.Release ();
+         }
       }
 
-      void LoadPart (string filename, int order) {
+      async void RestoreLastSession () {
+         if (!File.Exists (SessionPath)) return;
          try {
-            // Initialize and use IGESHandlerWrapper
-            igesHandler ??= new IGESHandlerWrapper ();
-            igesHandler.Initialize ();
-            igesHandler.LoadIGES (filename, order);
+            await RunOnHandlerAsync (() => {
+               igesHandler ??= new IGESHandlerWrapper ();
+               igesHandler.Initialize ();
+               igesHandler.RestoreSession (SessionPath);
+               igesHandler.PrepareView (false);
+            });
+            await DisplayInputsImageAsync ();
+         } catch (Exception ex) {
+            // A stale or damaged snapshot must not block startup
+            System.Diagnostics.Debug.WriteLine ($"Session restore skipped: {ex.Message}");
+         }
+      }
 
-            // Align to XY plane
-            igesHandler.AlignToXYPlane (order);
+      // Call on a pool thread with the gate held
+      void SaveSessionSnapshot () {
+         try {
+            Directory.CreateDirectory (Path.GetDirectoryName (SessionPath));
+            igesHandler?.SaveSession (SessionPath);
+         } catch (Exception ex) {
+            System.Diagnostics.Debug.WriteLine ($"Session snapshot failed: {ex.Message}");
+         }
+      }
 
-            // Render the IGES to a PNG byte array
-            byte[] pngData = igesHandler.DumpInputShapes (800, 600);
+      // Load, align and snapshot off the UI thread; only the text box and the frame are set here
+      async Task LoadPartAsync (string filename, int order) {
+         try {
+            await RunOnHandlerAsync (() => {
+               igesHandler ??= new IGESHandlerWrapper ();
+               igesHandler.Initialize ();
+               igesHandler.LoadShape (filename, order);
+
+               // Align to XY plane
+               igesHandler.AlignToXYPlane (order);
+               igesHandler.PrepareView (false);
+               SaveSessionSnapshot ();
+            });
 
             // Save the file path in the appropriate TextBox
             if (order == 0) {
@@ -38,9 +111,7 @@ namespace ProSMARTAPP {
             } else {
                Part2FileNameTextBox.Text = filename;
             }
-
-            // Display the PNG image in the ImageControl
-            DisplayInputsImage ();
+            await DisplayInputsImageAsync ();
          } catch (Exception ex) {
             MessageBox.Show (ex.Message, "Error", MessageBoxButton.OK, MessageBoxImage.Error);
          }
@@ -60,11 +131,7 @@ namespace ProSMARTAPP {
                // Set the busy cursor
                Mouse.OverrideCursor = Cursors.Wait;
 
-               // Perform the long-running operation on a background thread
-               await Task.Run (() => {
-                  // Ensure UI operations are marshaled back to the UI thread
-                  Application.Current.Dispatcher.Invoke (() => LoadPart (filePath, 0));
-               });
+               await LoadPartAsync (filePath, 0);
             } catch (Exception ex) {
                // Handle exceptions if needed
                MessageBox.Show ($"An error occurred: {ex.Message}", "Error", MessageBoxButton.OK, MessageBoxImage.Error);
@@ -91,11 +158,7 @@ namespace ProSMARTAPP {
                // Set the busy cursor
                Mouse.OverrideCursor = Cursors.Wait;
 
-               // Perform the long-running operation on a background thread
-               await Task.Run (() => {
-                  // Ensure UI operations are marshaled back to the UI thread
-                  Application.Current.Dispatcher.Invoke (() => LoadPart (filePath, 1));
-               });
+               await LoadPartAsync (filePath, 1);
             } catch (Exception ex) {
                // Handle exceptions if needed
                MessageBox.Show ($"An error occurred: {ex.Message}", "Error", MessageBoxButton.OK, MessageBoxImage.Error);
@@ -114,11 +177,12 @@ namespace ProSMARTAPP {
             Mouse.OverrideCursor = Cursors.Wait;
 
             // Perform the long-running operation on a background thread
-            await Task.Run (() => {
-               // Ensure UI operations are marshaled back to the UI thread
-               Application.Current.Dispatcher.Invoke (() => igesHandler.RotatePartBy180AboutZAxis (0));
+            await RunOnHandlerAsync (() => {
+               igesHandler.RotatePartBy180AboutZAxis (0);
+               igesHandler.PrepareView (false);
+               SaveSessionSnapshot ();
             });
-            DisplayInputsImage ();
+            await DisplayInputsImageAsync ();
          } catch (Exception ex) {
             // Handle exceptions if needed
             MessageBox.Show ($"An error occurred: {ex.Message}", "Error", MessageBoxButton.OK, MessageBoxImage.Error);
@@ -134,11 +198,12 @@ namespace ProSMARTAPP {
             Mouse.OverrideCursor = Cursors.Wait;
 
             // Perform the long-running operation on a background thread
-            await Task.Run (() => {
-               // Ensure UI operations are marshaled back to the UI thread
-               Application.Current.Dispatcher.Invoke (() => igesHandler.RotatePartBy180AboutZAxis (1));
+            await RunOnHandlerAsync (() => {
+               igesHandler.RotatePartBy180AboutZAxis (1);
+               igesHandler.PrepareView (false);
+               SaveSessionSnapshot ();
             });
-            DisplayInputsImage ();
+            await DisplayInputsImageAsync ();
          } catch (Exception ex) {
             // Handle exceptions if needed
             MessageBox.Show ($"An error occurred: {ex.Message}", "Error", MessageBoxButton.OK, MessageBoxImage.Error);
@@ -148,45 +213,53 @@ namespace ProSMARTAPP {
          }
       }
 
-      void DisplayInputsImage () {
-         if (igesHandler == null)
-            throw new Exception ("IGES Handler is null");
+      Task DisplayInputsImageAsync () => DisplayImageAsync (false);
 
-         byte[] imageData = igesHandler.DumpInputShapes (800, 600);
+      Task DisplayOutputImageAsync () => DisplayImageAsync (true);
 
-         using var stream = new MemoryStream (imageData);
-         var bitmap = new BitmapImage ();
-         bitmap.BeginInit ();
-         bitmap.CacheOption = BitmapCacheOption.OnLoad;
-         bitmap.StreamSource = stream;
-         bitmap.EndInit ();
-
-         ImageControl.Source = bitmap;
-      }
-      void DisplayOutputImage () {
+      // The persistent view lives on the UI thread; the gate keeps background work out meanwhile
+      async Task DisplayImageAsync (bool fused) {
          if (igesHandler == null)
             throw new Exception ("IGES Handler is null");
 
-         byte[] imageData = igesHandler.DumpFusedShape (800, 600);
+         ShowFrame (await WithHandlerAsync (() => igesHandler.RenderView (FrameWidth, FrameHeight, fused)));
+         RefineViewWhenReady ();
+      }
 
-         using var stream = new MemoryStream (imageData);
-         var bitmap = new BitmapImage ();
-         bitmap.BeginInit ();
-         bitmap.CacheOption = BitmapCacheOption.OnLoad;
-         bitmap.StreamSource = stream;
-         bitmap.EndInit ();
+      // The first frame may use a coarse mesh; redraw once the fine levels are meshed. The
+      // wait only watches the meshing jobs, so it does not hold the gate.
+      async void RefineViewWhenReady () {
+         try {
+            var handler = igesHandler;
+            if (handler == null || !await Task.Run (() => handler.WaitForDetail (60000))) return;
+            if (!mIsPanning && handler == igesHandler) TryWithHandler (() => ShowFrame (handler.EndInteraction ()));
+         } catch (Exception ex) {
+            System.Diagnostics.Debug.WriteLine ($"View refinement skipped: {ex.Message}");
+         }
+      }
 
-         ImageControl.Source = bitmap;
+      // Show a raw BGRA frame from the persistent view; the camera does the zoom and pan,
+      // so the image transforms are reset
+      void ShowFrame (byte[] frame) {
+         ImageControl.Source = BitmapSource.Create (FrameWidth, FrameHeight, 96, 96, PixelFormats.Bgr32, null, frame, FrameWidth * 4);
+         ImageScale.ScaleX = ImageScale.ScaleY = 1;
+         PanTransform.X = PanTransform.Y = 0;
+         mHasViewFrame = true;
       }
 
       void OnMouseWheel (object sender, MouseWheelEventArgs e) {
          try {
             if (igesHandler != null) {
-               if (e.Delta > 0) {
-                  igesHandler.ZoomIn ();
-               } else if (e.Delta < 0) {
-                  igesHandler.ZoomOut ();
-               }
+               TryWithHandler (() => {
+                  if (mHasViewFrame) {
+                     if (e.Delta != 0)
+                        ShowFrame (igesHandler.ZoomView (e.Delta > 0 ? ZoomFactor : 1 / ZoomFactor));
+                  } else if (e.Delta > 0) {
+                     igesHandler.ZoomIn ();
+                  } else if (e.Delta < 0) {
+                     igesHandler.ZoomOut ();
+                  }
+               });
                //DisplayImage();
             }
          } catch (Exception ex) {
@@ -196,9 +269,9 @@ namespace ProSMARTAPP {
 
       async void OnUnionClick (object sender, RoutedEventArgs e) {
          var saveFileDialog = new Microsoft.Win32.SaveFileDialog {
-            Title = "Save Unioned IGES File",
+            Title = "Save Unioned Part",
             DefaultExt = ".igs",
-            Filter = "IGES Files (*.igs)|*.igs|IGES Files (*.iges)|*.iges",
+            Filter = "IGES Files (*.igs)|*.igs|IGES Files (*.iges)|*.iges|STEP Files (*.stp;*.step)|*.stp;*.step|BRep Files (*.brep)|*.brep|STL Files (*.stl)|*.stl",
             InitialDirectory = @"W:\FChassis\Sample",
             FileName = "UnionResult.igs"
          };
@@ -207,41 +280,38 @@ namespace ProSMARTAPP {
             // Set the busy cursor
             Mouse.OverrideCursor = Cursors.Wait;
 
-            byte[] unionImageData = null;
-
             // Perform the union operation on a background thread
-            await Task.Run (() =>
+            await RunOnHandlerAsync (() =>
             {
                // Perform the union operation
                igesHandler.UnionShapes ();
 
-               // Generate the union image
-               unionImageData = igesHandler.DumpFusedShape (800, 600);
+               igesHandler.PrepareView (true);
+               SaveSessionSnapshot ();
             });
 
-            // Display the union image on the UI thread
-            if (unionImageData != null) {
-               await Application.Current.Dispatcher.InvokeAsync (() =>
-               {
-                  using var ms = new MemoryStream (unionImageData);
-                  var bitmap = new BitmapImage ();
-                  bitmap.BeginInit ();
-                  bitmap.CacheOption = BitmapCacheOption.OnLoad;
-                  bitmap.StreamSource = ms;
-                  bitmap.EndInit ();
-                  ImageControl.Source = bitmap;
-               });
-            }
+            // Display the union through the persistent view, which lives on the UI thread
+            await DisplayOutputImageAsync ();
 
-            // Show the file save dialog and save the IGES file
+            // Show the file save dialog and save the part in the chosen format
             if (saveFileDialog.ShowDialog () == true) {
-               await Task.Run (() =>
-               {
-                  // Save the unioned shape to the selected file
-                  igesHandler.SaveIGES (saveFileDialog.FileName, 2);
-               });
+               // Serialize off the UI thread, then write the bytes asynchronously
+               string extension = Path.GetExtension (saveFileDialog.FileName).ToLowerInvariant ();
+               if (extension == ".stl") {
+                  // STL needs the mesh and is written straight to the file
+                  await RunOnHandlerAsync (() => igesHandler.SaveShape (saveFileDialog.FileName, 2));
+               } else {
+                  var format = extension switch {
+                     ".stp" or ".step" => ExportFormat.STEP,
+                     ".brep" => ExportFormat.BRep,
+                     _ => ExportFormat.IGES
+                  };
+                  // The export captures the shape when it starts, so only the start holds the gate
+                  byte[] data = await await WithHandlerAsync (() => igesHandler.ExportToMemoryAsync (2, format));
+                  await File.WriteAllBytesAsync (saveFileDialog.FileName, data);
+               }
 
-               MessageBox.Show ($"Unioned IGES file saved successfully to {saveFileDialog.FileName}",
+               MessageBox.Show ($"Unioned part saved successfully to {saveFileDialog.FileName}",
                                "Save Successful", MessageBoxButton.OK, MessageBoxImage.Information);
             }
          } catch (Exception ex) {
@@ -292,7 +362,9 @@ namespace ProSMARTAPP {
 
       void ImageControl_MouseLeftButtonDown (object sender, MouseButtonEventArgs e) {
          mLastMousePosition = e.GetPosition (this); // Capture the mouse position
+         mPressPosition = mLastMousePosition;
          mIsPanning = true; // Enable panning
+         if (mHasViewFrame && igesHandler != null) TryWithHandler (igesHandler.BeginInteraction); // Coarse mesh while dragging
          ImageControl.CaptureMouse (); // Capture the mouse for continued event handling
       }
 
@@ -302,19 +374,71 @@ namespace ProSMARTAPP {
             double offsetX = currentMousePosition.X - mLastMousePosition.X; // Horizontal offset
             double offsetY = currentMousePosition.Y - mLastMousePosition.Y; // Vertical offset
 
-            PanTransform.X += offsetX; // Apply horizontal panning
-            PanTransform.Y += offsetY; // Apply vertical panning
+            if (mHasViewFrame) {
+               try {
+                  // Move the camera: drag pans, Shift+drag orbits
+                  double scale = FrameWidth / Math.Max (1.0, ImageControl.ActualWidth);
+                  TryWithHandler (() => ShowFrame (Keyboard.Modifiers.HasFlag (ModifierKeys.Shift)
+                     ? igesHandler.OrbitView (offsetX * 0.5, offsetY * 0.5)
+                     : igesHandler.PanView ((int)(offsetX * scale), (int)(-offsetY * scale))));
+               } catch (Exception ex) {
+                  mIsPanning = false;
+                  ImageControl.ReleaseMouseCapture ();
+                  MessageBox.Show ($"View update failed: {ex.Message}", "Error", MessageBoxButton.OK, MessageBoxImage.Error);
+               }
+            } else {
+               PanTransform.X += offsetX; // Apply horizontal panning
+               PanTransform.Y += offsetY; // Apply vertical panning
+            }
 
             mLastMousePosition = currentMousePosition; // Update the last position
+         } else if (mHasViewFrame && igesHandler != null) {
+            // Outline the face under the pointer; a frame is only drawn when it changes
+            Point position = e.GetPosition (ImageControl);
+            int x = (int)(position.X * FrameWidth / Math.Max (1.0, ImageControl.ActualWidth));
+            int y = (int)(position.Y * FrameHeight / Math.Max (1.0, ImageControl.ActualHeight));
+            try {
+               TryWithHandler (() => {
+                  byte[] frame = igesHandler.Hover (x, y);
+                  if (frame != null) ShowFrame (frame);
+               });
+            } catch (Exception ex) {
+               System.Diagnostics.Debug.WriteLine ($"Hover skipped: {ex.Message}");
+            }
          }
       }
 
       void ImageControl_MouseLeftButtonUp (object sender, MouseButtonEventArgs e) {
          mIsPanning = false; // Disable panning
          ImageControl.ReleaseMouseCapture (); // Release the mouse capture
+         if (mHasViewFrame && igesHandler != null) {
+            try {
+               bool click = (e.GetPosition (this) - mPressPosition).Length < 3;
+               Point position = e.GetPosition (ImageControl);
+               TryWithHandler (() => {
+                  ShowFrame (igesHandler.EndInteraction ()); // Back to the fine mesh
+                  if (click) PickAt (position);
+               });
+            } catch (Exception ex) {
+               MessageBox.Show ($"View update failed: {ex.Message}", "Error", MessageBoxButton.OK, MessageBoxImage.Error);
+            }
+         }
+      }
+
+      // Select the face under a click, highlight it and describe it in the title bar; call with the gate held
+      void PickAt (Point position) {
+         int x = (int)(position.X * FrameWidth / Math.Max (1.0, ImageControl.ActualWidth));
+         int y = (int)(position.Y * FrameHeight / Math.Max (1.0, ImageControl.ActualHeight));
+         PickInfo pick = igesHandler.Pick (x, y);
+         ShowFrame (igesHandler.HighlightFace (pick.Order, pick.Hit ? pick.Face : 0));
+         string part = pick.Order == 0 ? "Left part" : pick.Order == 3 ? "Mirrored part" : "Result";
+         Title = pick.Hit
+            ? $"ProSMART Part Viewer - {part}, face {pick.Face}" + (pick.Edge > 0 ? $", edge {pick.Edge}" : "") + $" at ({pick.X:F2}, {pick.Y:F2}, {pick.Z:F2})"
+            : "ProSMART Part Viewer";
       }
 
       void ImageControl_MouseWheel (object sender, MouseWheelEventArgs e) {
+         if (mHasViewFrame) return; // The window handler zooms the camera instead
          double zoomFactor = e.Delta > 0 ? 1.1 : 0.9; // Zoom in or out
          Point mousePosition = e.GetPosition (ImageControl); // Get mouse position relative to the image
 
@@ -0,0 +1,177 @@
+﻿using System.Diagnostics;
+using System.Net;
+using System.Net.Sockets;
+using System.Text.Json;
+using Xunit;
+
+namespace ProSMARTCLI.Tests;
+
+/// <summary>
+/// One --smoke run shared by the tests: its report, and the parts it generated
+/// </summary>
+public sealed class SmokeRun : IDisposable {
+   public SmokeRun () {
+      WorkDir = Path.Combine (Path.GetTempPath (), "ProSMARTCLI.Smoke." + Guid.NewGuid ().ToString ("N"));
+      (ExitCode, Output, Error) = CliSmokeTests.RunCli ("--smoke", WorkDir);
+   }
+
+   public string WorkDir { get; }
+   public int ExitCode { get; }
+   public string Output { get; }
+   public string Error { get; }
+
+   public void Dispose () {
+      if (Directory.Exists (WorkDir)) Directory.Delete (WorkDir, true);
+   }
+}
+
+/// <summary>
+/// Runs the console tool as a separate process, the way scripts and CI call it
+/// </summary>
+public class CliSmokeTests : IClassFixture<SmokeRun> {
+   readonly SmokeRun mSmoke;
+
+   public CliSmokeTests (SmokeRun smoke) {
+      mSmoke = smoke;
+   }
+
+   [Fact]
+   public void UnknownCommandPrintsUsage () {
+      var (exitCode, _, error) = RunCli ("--no-such-command");
+      Assert.Equal (2, exitCode);
+      Assert.Contains ("Usage:", error);
+   }
+
+   [Fact]
+   public void SmokeTestRunsThePipeline () {
+      Assert.True (mSmoke.ExitCode == 0, $"Exit code {mSmoke.ExitCode}\n{mSmoke.Output}\n{mSmoke.Error}");
+      using var report = JsonDocument.Parse (File.ReadAllText (Path.Combine (mSmoke.WorkDir, "smoke.json")));
+      Assert.Equal ("prosmart-bench/1", report.RootElement.GetProperty ("schema").GetString ());
+      var samples = report.RootElement.GetProperty ("samples").EnumerateArray ().ToList ();
+      foreach (string part in new[] { "ExtrudedProfile_100", "RevolvedFlex_100" }) {
+         var operations = samples.Where (s => s.GetProperty ("part").GetString () == part).ToList ();
+         Assert.True (operations.Count > 0, $"{part} was not benchmarked");
+         Assert.True (operations[0].GetProperty ("faces").GetInt32 () > 0);
+         foreach (string operation in new[] { "LoadIGES", "AlignToXYPlane", "MirrorLods", "SaveIGES", "UnionShapes", "UnionShapes/SeamLocal", "SaveAsIGS" }) {
+            var sample = operations.SingleOrDefault (s => s.GetProperty ("operation").GetString () == operation);
+            Assert.True (sample.ValueKind == JsonValueKind.Object, $"{part}: {operation} did not run");
+            Assert.False (sample.TryGetProperty ("error", out var error), $"{part}: {operation} failed: {error}");
+            Assert.True (sample.GetProperty ("runs").GetInt32 () >= 1, $"{part}: {operation} has no timed run");
+         }
+         Assert.True (new FileInfo (Path.Combine (mSmoke.WorkDir, part + "_fused.igs")).Length > 0, $"{part}: no fused part was saved");
+      }
+   }
+
+   [Fact]
+   public void ServiceLoadsUnitesAndExportsAPart () {
+      Assert.True (mSmoke.ExitCode == 0, "The smoke run that writes the input part failed.");
+      string part = Path.Combine (mSmoke.WorkDir, "ExtrudedProfile_100.igs");
+      string fused = Path.Combine (mSmoke.WorkDir, "ServiceFused.step");
+      int port = FreePort ();
+      using var server = StartCli ("--serve", port.ToString (), "8", "secret");
+      try {
+         using var client = Connect (port);
+         using var stream = client.GetStream ();
+         using var reader = new StreamReader (stream);
+         using var writer = new StreamWriter (stream) { AutoFlush = true, NewLine = "\n" };
+         string Request (string line) {
+            writer.WriteLine (line);
+            return reader.ReadLine () ?? "";
+         }
+         string Job (string line) {
+            string reply = Request (line);
+            Assert.StartsWith ("OK ", reply);
+            return reply.Substring (3);
+         }
+
+         string session = Job ("OPEN");
+         var jobs = new[] {
+            Job ($"LOAD {session} left {part}"),
+            Job ($"ALIGN {session} left"),
+            Job ($"UNION {session}"),
+            Job ($"EXPORT {session} fused {fused}"),
+         };
+         foreach (string job in jobs) Assert.StartsWith ("DONE", Request ($"WAIT {job}"));
+         Assert.True (new FileInfo (fused).Length > 0, "The fused part was not exported.");
+
+         // The exported file loads back as a part of its own
+         Assert.StartsWith ("DONE", Request ($"WAIT {Job ($"LOAD {session} right {fused}")}"));
+         // Sessions belong to the connection that opened them
+         using (var other = Connect (port))
+         using (var otherStream = other.GetStream ())
+         using (var otherReader = new StreamReader (otherStream))
+         using (var otherWriter = new StreamWriter (otherStream) { AutoFlush = true, NewLine = "\n" }) {
+            otherWriter.WriteLine ($"UNION {session}");
+            Assert.StartsWith ("ERR", otherReader.ReadLine ());
+         }
+         Assert.Equal ("OK", Request ($"CLOSE {session}"));
+         Assert.Equal ("OK", Request ("SHUTDOWN secret"));
+         Assert.True (server.WaitForExit (30000), "The service did not stop.");
+      } finally {
+         if (!server.HasExited) server.Kill ();
+      }
+   }
+
+   [Fact]
+   public void ServiceStopsOnlyForItsShutdownToken () {
+      int port = FreePort ();
+      using var server = StartCli ("--serve", port.ToString (), "4", "secret");
+      try {
+         using var client = Connect (port);
+         using var stream = client.GetStream ();
+         using var reader = new StreamReader (stream);
+         using var writer = new StreamWriter (stream) { AutoFlush = true, NewLine = "\n" };
+         writer.WriteLine ("STATUS 1");
+         Assert.StartsWith ("ERR", reader.ReadLine ());
+         writer.WriteLine ("SHUTDOWN wrong");
+         Assert.StartsWith ("ERR", reader.ReadLine ());
+         writer.WriteLine ("SHUTDOWN secret");
+         Assert.Equal ("OK", reader.ReadLine ());
+         Assert.True (server.WaitForExit (30000), "The service did not stop.");
+         Assert.Equal (0, server.ExitCode);
+      } finally {
+         if (!server.HasExited) server.Kill ();
+      }
+   }
+
+   static int FreePort () {
+      var probe = new TcpListener (IPAddress.Loopback, 0);
+      probe.Start ();
+      int port = ((IPEndPoint)probe.LocalEndpoint).Port;
+      probe.Stop ();
+      return port;
+   }
+
+   static TcpClient Connect (int port) {
+      // The service needs a moment to start listening
+      for (int attempt = 0; ; attempt++) {
+         try {
+            return new TcpClient ("127.0.0.1", port);
+         } catch (SocketException) when (attempt < 100) {
+            Thread.Sleep (100);
+         }
+      }
+   }
+
+   static Process StartCli (params string[] args) {
+      var start = new ProcessStartInfo ("dotnet") { UseShellExecute = false };
+      start.ArgumentList.Add (Path.Combine (AppContext.BaseDirectory, "ProSMARTCLI.dll"));
+      foreach (string arg in args) start.ArgumentList.Add (arg);
+      return Process.Start (start)!;
+   }
+
+   internal static (int ExitCode, string Output, string Error) RunCli (params string[] args) {
+      var start = new ProcessStartInfo ("dotnet") {
+         RedirectStandardOutput = true,
+         RedirectStandardError = true,
+         UseShellExecute = false,
+      };
+      start.ArgumentList.Add (Path.Combine (AppContext.BaseDirectory, "ProSMARTCLI.dll"));
+      foreach (string arg in args) start.ArgumentList.Add (arg);
+      using var process = Process.Start (start)!;
+      var output = process.StandardOutput.ReadToEndAsync ();
+      var error = process.StandardError.ReadToEndAsync ();
+      process.WaitForExit ();
+      return (process.ExitCode, output.Result, error.Result);
+   }
+}
@@ -0,0 +1,65 @@
+﻿using System.Globalization;
+using IGESWrapper;
+
+namespace ProSMARTCLI;
+
+/// <summary>
+/// Headless entry point for the tools that need no window: a real console process, so
+/// output and failures reach the caller and the exit code reports the result
+/// </summary>
+public static class Program {
+   const int Ok = 0, Failed = 1, Usage = 2;
+
+   public static int Main (string[] args) {
+      CultureInfo.CurrentCulture = new CultureInfo ("en-US");
+      CultureInfo.CurrentUICulture = new CultureInfo ("en-US");
+      if (args.Length == 0) return PrintUsage ();
+      try {
+         return Run (args);
+      } catch (Exception ex) {
+         Console.Error.WriteLine ($"{args[0]} failed: {ex.Message}");
+         return Failed;
+      }
+   }
+
+   static int Run (string[] args) {
+      switch (args[0]) {
+         case "--benchmark":
+            if (args.Length < 3) return PrintUsage ();
+            IGESHandlerWrapper.RunBenchmarks (args[1], args[2]);
+            return Ok;
+         case "--smoke":
+            if (args.Length < 2) return PrintUsage ();
+            int failed = IGESHandlerWrapper.RunSmokeTest (args[1]);
+            Console.WriteLine (failed == 0 ? "Smoke test passed." : $"Smoke test: {failed} operations failed.");
+            return failed == 0 ? Ok : Failed;
+         case "--thumbnails":
+            if (args.Length < 3) return PrintUsage ();
+            int size = args.Length > 3 ? int.Parse (args[3], CultureInfo.InvariantCulture) : 256;
+            Console.WriteLine (IGESHandlerWrapper.RunThumbnails (args[1], args[2], size));
+            return Ok;
+         case "--serve":
+            if (args.Length < 2) return PrintUsage ();
+            int capacity = args.Length > 2 ? int.Parse (args[2], CultureInfo.InvariantCulture) : 16;
+            IGESHandlerWrapper.RunJobService (int.Parse (args[1], CultureInfo.InvariantCulture), capacity, args.Length > 3 ? args[3] : null);
+            return Ok;
+         case "--loadgen":
+            if (args.Length < 4) return PrintUsage ();
+            int clients = args.Length > 4 ? int.Parse (args[4], CultureInfo.InvariantCulture) : 4;
+            int workflows = args.Length > 5 ? int.Parse (args[5], CultureInfo.InvariantCulture) : 5;
+            Console.WriteLine (IGESHandlerWrapper.RunLoadGenerator (int.Parse (args[1], CultureInfo.InvariantCulture), args[2], args[3], clients, workflows));
+            return Ok;
+      }
+      return PrintUsage ();
+   }
+
+   static int PrintUsage () {
+      Console.Error.WriteLine ("Usage:");
+      Console.Error.WriteLine ("  ProSMARTCLI --benchmark <workDir> <results.json>");
+      Console.Error.WriteLine ("  ProSMARTCLI --smoke <workDir>");
+      Console.Error.WriteLine ("  ProSMARTCLI --thumbnails <partsDir> <outputDir> [size]");
+      Console.Error.WriteLine ("  ProSMARTCLI --serve <port> [queueCapacity] [shutdownToken]");
+      Console.Error.WriteLine ("  ProSMARTCLI --loadgen <port> <part> <outputDir> [clients] [workflowsPerClient]");
+      return Usage;
+   }
+}
@@ -0,0 +1,31 @@
+#include <omp.h>
+#include <BRepBndLib.hxx>
+#include <TopExp.hxx>
+#include "FaceBoxIndex.h"
+
+void FaceBoxIndex::Build(const TopoDS_Shape& shape)
+{
+   mFaces.Clear();
+   TopExp::MapShapes(shape, TopAbs_FACE, mFaces);
+   const int nFaces = mFaces.Extent();
+   mBoxes.assign(nFaces, Bnd_Box());
+
+#pragma omp parallel for schedule(dynamic, 16)
+   for (int i = 0; i < nFaces; ++i) {
+      BRepBndLib::Add(mFaces(i + 1), mBoxes[i]);
+   }
+}
+
+std::vector<int> FaceBoxIndex::FacesCrossing(int axis, double value) const
+{
+   std::vector<int> faces;
+   for (int i = 0; i < static_cast<int>(mBoxes.size()); ++i) {
+      if (mBoxes[i].IsVoid()) continue;
+      double xmin, ymin, zmin, xmax, ymax, zmax;
+      mBoxes[i].Get(xmin, ymin, zmin, xmax, ymax, zmax);
+      const double low = axis == 1 ? xmin : axis == 2 ? ymin : zmin;
+      const double high = axis == 1 ? xmax : axis == 2 ? ymax : zmax;
+      if (low <= value && value <= high) faces.push_back(i + 1);
+   }
+   return faces;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <vector>
+#include <Bnd_Box.hxx>
+#include <TopoDS_Shape.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+
+// Bounding box of every face of a shape, so plane and box queries can skip faces
+// without touching their geometry. Built once per shape and shared read-only.
+class FaceBoxIndex
+{
+public:
+   // Boxes are computed in parallel and enlarged by the face tolerances
+   void Build(const TopoDS_Shape& shape);
+
+   const TopTools_IndexedMapOfShape& Faces() const { return mFaces; }
+   const Bnd_Box& Box(int faceIndex) const { return mBoxes[faceIndex - 1]; } // 1-based, as Faces()
+
+   // Faces whose box reaches the plane coordinate(axis) == value; axis is 1, 2 or 3 for X, Y, Z
+   std::vector<int> FacesCrossing(int axis, double value) const;
+
+private:
+   TopTools_IndexedMapOfShape mFaces;
+   std::vector<Bnd_Box> mBoxes;
+};
@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+#include <BRepBndLib.hxx>
+#include <BRepBuilderAPI_Copy.hxx>
+#include <BRepMesh_IncrementalMesh.hxx>
+#include <BRep_Tool.hxx>
+#include <Bnd_Box.hxx>
+#include <Bnd_OBB.hxx>
+#include <Poly_Triangulation.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Face.hxx>
+#include <TopoDS_Shape.hxx>
+#include <gp_Ax3.hxx>
+#include <math_Jacobi.hxx>
+#include <math_Matrix.hxx>
+#include <math_Vector.hxx>
+#include <omp.h>
+
+#include "IGESAlignment.h"
+#include "IGESTrace.h"
+#include "MeshBVH.h"
+
+namespace
+{
+   // Flip an axis so its largest world component is positive; keeps the frame stable
+   // between runs, since eigen and box axes come with an arbitrary sign
+   gp_Dir Canonical(const gp_Dir& d) {
+      const double components[3] = { d.X(), d.Y(), d.Z() };
+      const double* largest = std::max_element(components, components + 3,
+         [](double a, double b) { return std::abs(a) < std::abs(b); });
+      return *largest < 0 ? d.Reversed() : d;
+   }
+
+   // Axes given in any order with their extents; returns X longest, Z shortest
+   gp_Ax3 FrameFromAxes(const gp_Pnt& center, std::array<std::pair<double, gp_Dir>, 3> axes) {
+      std::sort(axes.begin(), axes.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+      const gp_Dir xAxis = Canonical(axes[0].second);
+      gp_Dir zAxis = Canonical(axes[2].second);
+      // Re-orthogonalize, the axes are only orthogonal up to round-off
+      zAxis = gp_Dir(zAxis.XYZ() - xAxis.XYZ() * zAxis.XYZ().Dot(xAxis.XYZ()));
+      return gp_Ax3(center, zAxis, xAxis);
+   }
+
+   gp_Ax3 OrientedBoxFrame(const TopoDS_Shape& shape) {
+      Bnd_OBB box;
+      BRepBndLib::AddOBB(shape, box);
+      if (box.IsVoid()) throw std::runtime_error("Cannot compute the oriented bounding box of the shape.");
+      return FrameFromAxes(gp_Pnt(box.Center()), {
+         std::make_pair(box.XHSize(), gp_Dir(box.XDirection())),
+         std::make_pair(box.YHSize(), gp_Dir(box.YDirection())),
+         std::make_pair(box.ZHSize(), gp_Dir(box.ZDirection())) });
+   }
+
+   // Covariance of the surface, integrated exactly over each triangle of a coarse mesh so
+   // the result does not depend on how densely each face is meshed
+   gp_Ax3 PrincipalAxesFrame(const TopoDS_Shape& shape) {
+      Bnd_Box bounds;
+      BRepBndLib::Add(shape, bounds);
+      if (bounds.IsVoid()) throw std::runtime_error("Cannot compute the principal axes of an empty shape.");
+
+      // Mesh a copy so the stored triangulations of the part are left alone
+      TopoDS_Shape copy = BRepBuilderAPI_Copy(shape, Standard_True, Standard_False).Shape();
+      BRepMesh_IncrementalMesh mesher(copy, 5e-3 * std::sqrt(bounds.SquareExtent()), Standard_False, 0.5, Standard_True);
+
+      // Triangle vertices in flat arrays, so the moment sums below are simple loops over doubles
+      std::vector<double> x, y, z;
+      for (TopExp_Explorer explorer(copy, TopAbs_FACE); explorer.More(); explorer.Next()) {
+         TopLoc_Location location;
+         Handle(Poly_Triangulation) mesh = BRep_Tool::Triangulation(TopoDS::Face(explorer.Current()), location);
+         if (mesh.IsNull()) continue;
+         const gp_Trsf& trsf = location.Transformation();
+         for (int i = 1; i <= mesh->NbTriangles(); ++i) {
+            int n[3];
+            mesh->Triangle(i).Get(n[0], n[1], n[2]);
+            for (int k = 0; k < 3; ++k) {
+               const gp_Pnt p = mesh->Node(n[k]).Transformed(trsf);
+               x.push_back(p.X());
+               y.push_back(p.Y());
+               z.push_back(p.Z());
+            }
+         }
+      }
+      const std::size_t nTriangles = x.size() / 3;
+      if (nTriangles == 0) throw std::runtime_error("Cannot compute the principal axes: the shape could not be meshed.");
+
+      // First pass: area-weighted centroid
+      std::vector<double> area(nTriangles);
+      double totalArea = 0, mx = 0, my = 0, mz = 0;
+      for (std::size_t t = 0; t < nTriangles; ++t) {
+         const std::size_t i = 3 * t;
+         const double ux = x[i + 1] - x[i], uy = y[i + 1] - y[i], uz = z[i + 1] - z[i];
+         const double vx = x[i + 2] - x[i], vy = y[i + 2] - y[i], vz = z[i + 2] - z[i];
+         const double cx = uy * vz - uz * vy, cy = uz * vx - ux * vz, cz = ux * vy - uy * vx;
+         area[t] = 0.5 * std::sqrt(cx * cx + cy * cy + cz * cz);
+         totalArea += area[t];
+         mx += area[t] * (x[i] + x[i + 1] + x[i + 2]) / 3.0;
+         my += area[t] * (y[i] + y[i + 1] + y[i + 2]) / 3.0;
+         mz += area[t] * (z[i] + z[i + 1] + z[i + 2]) / 3.0;
+      }
+      if (totalArea <= 0) throw std::runtime_error("Cannot compute the principal axes of a shape without area.");
+      mx /= totalArea;
+      my /= totalArea;
+      mz /= totalArea;
+
+      // Second pass: for a triangle with vertices v and centroid c, the integral of
+      // (p - m)(p - m)^T is area * ((c - m)(c - m)^T + sum((v - c)(v - c)^T) / 12)
+      double sxx = 0, syy = 0, szz = 0, sxy = 0, sxz = 0, syz = 0;
+      for (std::size_t t = 0; t < nTriangles; ++t) {
+         const std::size_t i = 3 * t;
+         const double cx = (x[i] + x[i + 1] + x[i + 2]) / 3.0;
+         const double cy = (y[i] + y[i + 1] + y[i + 2]) / 3.0;
+         const double cz = (z[i] + z[i + 1] + z[i + 2]) / 3.0;
+         double txx = 0, tyy = 0, tzz = 0, txy = 0, txz = 0, tyz = 0;
+         for (int k = 0; k < 3; ++k) {
+            const double dx = x[i + k] - cx, dy = y[i + k] - cy, dz = z[i + k] - cz;
+            txx += dx * dx; tyy += dy * dy; tzz += dz * dz;
+            txy += dx * dy; txz += dx * dz; tyz += dy * dz;
+         }
+         const double ex = cx - mx, ey = cy - my, ez = cz - mz;
+         const double a = area[t];
+         sxx += a * (ex * ex + txx / 12.0);
+         syy += a * (ey * ey + tyy / 12.0);
+         szz += a * (ez * ez + tzz / 12.0);
+         sxy += a * (ex * ey + txy / 12.0);
+         sxz += a * (ex * ez + txz / 12.0);
+         syz += a * (ey * ez + tyz / 12.0);
+      }
+
+      math_Matrix covariance(1, 3, 1, 3);
+      covariance(1, 1) = sxx; covariance(1, 2) = sxy; covariance(1, 3) = sxz;
+      covariance(2, 1) = sxy; covariance(2, 2) = syy; covariance(2, 3) = syz;
+      covariance(3, 1) = sxz; covariance(3, 2) = syz; covariance(3, 3) = szz;
+      math_Jacobi jacobi(covariance);
+      if (!jacobi.IsDone()) throw std::runtime_error("Principal axes computation did not converge.");
+
+      std::array<std::pair<double, gp_Dir>, 3> axes;
+      math_Vector vector(1, 3);
+      for (int k = 1; k <= 3; ++k) {
+         jacobi.Vector(k, vector);
+         axes[k - 1] = std::make_pair(jacobi.Value(k), gp_Dir(vector(1), vector(2), vector(3)));
+      }
+      return FrameFromAxes(gp_Pnt(mx, my, mz), axes);
+   }
+
+   // Length of a ray inside a closed mesh, from its ascending crossings and whether it
+   // starts inside
+   double InsideLength(const std::vector<double>& crossings, bool inside) {
+      double length = 0, enter = 0;
+      for (double t : crossings) {
+         if (inside) length += t - enter;
+         else enter = t;
+         inside = !inside;
+      }
+      return length;
+   }
+}
+
+gp_Ax3 IGESAlignment::PrincipalFrame(const TopoDS_Shape& shape, AlignmentMode mode)
+{
+   switch (mode) {
+   case AlignmentMode::OrientedBox: {
+      PROSMART_TRACE_SCOPE("PrincipalFrame/OrientedBox");
+      return OrientedBoxFrame(shape);
+   }
+   case AlignmentMode::PCA: {
+      PROSMART_TRACE_SCOPE("PrincipalFrame/PCA");
+      return PrincipalAxesFrame(shape);
+   }
+   default:
+      throw std::invalid_argument("PrincipalFrame needs the OrientedBox or PCA mode.");
+   }
+}
+
+FlipVote IGESAlignment::ClassifyFlip(const TopoDS_Shape& shape, int gridSize)
+{
+   PROSMART_TRACE_SCOPE("ClassifyFlip");
+   auto start = std::chrono::steady_clock::now();
+   Bnd_Box bounds;
+   BRepBndLib::Add(shape, bounds);
+   if (bounds.IsVoid()) throw std::runtime_error("Cannot classify the orientation of an empty shape.");
+   double xmin, ymin, zmin, xmax, ymax, zmax;
+   bounds.Get(xmin, ymin, zmin, xmax, ymax, zmax);
+
+   // The mesh is trimmed, so unlike the surface test a ray cannot hit the untrimmed
+   // extension of a face. A stored mesh fine enough is used as it is.
+   BRepMesh_IncrementalMesh mesher(shape, 2e-3 * std::sqrt(bounds.SquareExtent()), Standard_False, 0.5, Standard_True);
+   MeshBVH bvh;
+   bvh.Build(shape);
+   if (bvh.IsEmpty()) throw std::runtime_error("Cannot classify the orientation: the shape could not be meshed.");
+
+   // Rays start inside the footprint, away from the rim where side walls graze them
+   const int n = std::max(2, gridSize);
+   const double zMid = (zmin + zmax) / 2.0;
+   const double marginX = 0.05 * (xmax - xmin), marginY = 0.05 * (ymax - ymin);
+   const double stepX = (xmax - xmin - 2 * marginX) / (n - 1);
+   const double stepY = (ymax - ymin - 2 * marginY) / (n - 1);
+   const gp_XYZ down(0, 0, -1), up(0, 0, 1);
+   const double margin = 1e-6 * (zmax - zmin);
+
+   int flipVotes = 0, keepVotes = 0;
+#pragma omp parallel for schedule(static) reduction(+ : flipVotes, keepVotes)
+   for (int k = 0; k < n * n; ++k) {
+      const gp_XYZ origin(xmin + marginX + (k % n) * stepX, ymin + marginY + (k / n) * stepY, zMid);
+      const std::vector<double> below = bvh.Crossings(origin, down);
+      const std::vector<double> above = bvh.Crossings(origin, up);
+      double materialBelow, materialAbove;
+      if ((below.size() + above.size()) % 2 == 0) {
+         // The line crosses a closed mesh: weigh the length inside it on each side
+         const bool inside = below.size() % 2 == 1;
+         materialBelow = InsideLength(below, inside);
+         materialAbove = InsideLength(above, inside);
+      }
+      else {
+         // An open sheet has no inside, only whether it is there
+         materialBelow = below.empty() ? 0.0 : 1.0;
+         materialAbove = above.empty() ? 0.0 : 1.0;
+      }
+      if (materialBelow > materialAbove + margin) ++flipVotes;
+      else if (materialAbove > materialBelow + margin) ++keepVotes;
+   }
+
+   FlipVote vote;
+   vote.nRays = n * n;
+   vote.flipVotes = flipVotes;
+   vote.keepVotes = keepVotes;
+   vote.flip = flipVotes > keepVotes;
+   vote.confidence = std::abs(flipVotes - keepVotes) / static_cast<double>(vote.nRays);
+   vote.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   return vote;
+}
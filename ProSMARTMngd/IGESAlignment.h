@@ -0,0 +1,45 @@
+#pragma once
+
+class TopoDS_Shape;
+class gp_Ax3;
+
+// How AlignToXYPlane finds the length, width and thickness directions of a part
+enum class AlignmentMode
+{
+   AxisAligned, // Permute the world axes by the axis-aligned box extents; exact only for parts modelled square to the world
+   OrientedBox, // Axes of the minimal oriented bounding box (BRepBndLib::AddOBB)
+   PCA          // Principal axes of the area-weighted surface triangles of a coarse mesh
+};
+
+// How AlignToXYPlane decides whether the aligned part must be turned over
+enum class FlipTest
+{
+   SingleRay, // One -Z ray from the box centre against the untrimmed face surfaces
+   RayGrid    // Vote of a grid of rays against a coarse mesh, falling back to SingleRay when unsure
+};
+
+// Outcome of the ray-grid flip vote. A ray from the mid-height of the box votes "flip" when
+// it finds more material below than above, "keep" for the opposite, and abstains on a tie.
+// Material is the length inside the part where the ray crosses a closed mesh, and mere
+// presence where it crosses an open sheet.
+struct FlipVote
+{
+   bool flip = false;
+   double confidence = 0; // |flip votes - keep votes| / rays, 0..1
+   int flipVotes = 0;
+   int keepVotes = 0;
+   int nRays = 0;
+   double seconds = 0;
+};
+
+class IGESAlignment
+{
+public:
+   // Right-handed frame centred on the part with X along its longest extent and Z along its
+   // shortest. Not defined for AlignmentMode::AxisAligned.
+   static gp_Ax3 PrincipalFrame(const TopoDS_Shape& shape, AlignmentMode mode);
+
+   // Cast gridSize x gridSize vertical ray pairs over the box footprint, in parallel. Meshes
+   // the shape in place where its stored mesh is missing or too coarse.
+   static FlipVote ClassifyFlip(const TopoDS_Shape& shape, int gridSize = 16);
+};
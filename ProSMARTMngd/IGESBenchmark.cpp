@@ -0,0 +1,393 @@
+#define _USE_MATH_DEFINES
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <BRep_Builder.hxx>
+#include <BRepBndLib.hxx>
+#include <BRepBuilderAPI_Copy.hxx>
+#include <BRepBuilderAPI_MakeEdge.hxx>
+#include <BRepBuilderAPI_MakeFace.hxx>
+#include <BRepBuilderAPI_MakeVertex.hxx>
+#include <BRepBuilderAPI_Transform.hxx>
+#include <BRepPrimAPI_MakePrism.hxx>
+#include <BRepPrimAPI_MakeRevol.hxx>
+#include <Bnd_Box.hxx>
+#include <Geom_BezierCurve.hxx>
+#include <IGESControl_Writer.hxx>
+#include <Standard_Version.hxx>
+#include <TColgp_Array1OfPnt.hxx>
+#include <TopExp.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Face.hxx>
+#include <TopoDS_Shape.hxx>
+#include <TopoDS_Vertex.hxx>
+#include <TopoDS_Wire.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+#include <gp.hxx>
+#include <gp_Ax1.hxx>
+#include <gp_Trsf.hxx>
+#include <gp_Vec.hxx>
+
+#include "IGESBenchmark.h"
+#include "IGESHandler.h"
+#include "IGESAlignment.h"
+#include "IGESSessionEngine.h"
+#include "MeshBVH.h"
+
+namespace
+{
+   const double kProfileWidth = 100.0;  // Across the corrugations (Y)
+   const double kSheetThickness = 1.5;
+   const double kPartLength = 1000.0;   // Extrusion length (X)
+   const double kBendRadius = 20.0;
+   const unsigned kSeed = 20240601;      // Fixed so every run builds identical parts
+
+   // The angle GeneratePart models the part at, so that alignment has real work to do
+   gp_Trsf PartTilt() {
+      gp_Trsf tiltZ, tiltY;
+      tiltZ.SetRotation(gp_Ax1(gp::Origin(), gp_Dir(0, 0, 1)), 30.0 * M_PI / 180.0);
+      tiltY.SetRotation(gp_Ax1(gp::Origin(), gp_Dir(0, 1, 0)), 10.0 * M_PI / 180.0);
+      return tiltY * tiltZ;
+   }
+
+   // Number of ridges needed so that a part built from the profile has ~targetFaces faces.
+   // The closed profile has 4 * ridges + 2 edges; extrusion/revolution adds two caps.
+   int RidgesForFaces(int targetFaces) {
+      return std::max(1, (targetFaces - 4) / 4);
+   }
+
+   // Closed corrugated profile in the YZ plane (x = 0): a zig-zag top line from y = 0 to
+   // y = kProfileWidth, and the same line shifted down by the sheet thickness coming back.
+   std::vector<gp_Pnt> CorrugatedProfile(int ridges) {
+      std::mt19937 rng(kSeed);
+      std::uniform_real_distribution<double> ridgeHeight(2.0, 6.0);
+
+      const int nTop = 2 * ridges + 1;
+      const double pitch = kProfileWidth / (nTop - 1);
+      std::vector<double> topZ(nTop);
+      for (int i = 0; i < nTop; ++i) {
+         topZ[i] = kSheetThickness + ((i % 2 == 1) ? ridgeHeight(rng) : 0.0);
+      }
+
+      std::vector<gp_Pnt> pts;
+      pts.reserve(2 * nTop);
+      for (int i = 0; i < nTop; ++i) {
+         pts.emplace_back(0.0, i * pitch, topZ[i]);
+      }
+      for (int i = nTop - 1; i >= 0; --i) {
+         pts.emplace_back(0.0, i * pitch, topZ[i] - kSheetThickness);
+      }
+      return pts;
+   }
+
+   // Planar face bounded by the profile. With curvedEdges the corrugation edges are
+   // quadratic Bezier arcs, so sweeping them yields general surfaces of revolution.
+   TopoDS_Face ProfileFace(const std::vector<gp_Pnt>& pts, bool curvedEdges) {
+      const int n = static_cast<int>(pts.size());
+      const int nTop = n / 2;
+      std::vector<TopoDS_Vertex> vertices(n);
+      for (int i = 0; i < n; ++i) {
+         vertices[i] = BRepBuilderAPI_MakeVertex(pts[i]);
+      }
+
+      BRep_Builder builder;
+      TopoDS_Wire wire;
+      builder.MakeWire(wire);
+      for (int i = 0; i < n; ++i) {
+         const int j = (i + 1) % n;
+         // The two closing edges (i = nTop - 1 and i = n - 1) are the vertical sheet ends
+         bool isSheetEnd = (i == nTop - 1) || (i == n - 1);
+         if (curvedEdges && !isSheetEnd) {
+            // Bulge in Z by the same amount on top and bottom lines so they stay one thickness apart
+            gp_Pnt mid((pts[i].XYZ() + pts[j].XYZ()) * 0.5);
+            mid.SetZ(mid.Z() + 0.25);
+            TColgp_Array1OfPnt poles(1, 3);
+            poles(1) = pts[i];
+            poles(2) = mid;
+            poles(3) = pts[j];
+            Handle(Geom_Curve) arc = new Geom_BezierCurve(poles);
+            builder.Add(wire, BRepBuilderAPI_MakeEdge(arc, vertices[i], vertices[j]).Edge());
+         }
+         else {
+            builder.Add(wire, BRepBuilderAPI_MakeEdge(vertices[i], vertices[j]).Edge());
+         }
+      }
+      wire.Closed(Standard_True);
+
+      BRepBuilderAPI_MakeFace makeFace(wire, Standard_True);
+      if (!makeFace.IsDone()) {
+         throw std::runtime_error("Failed to build the synthetic profile face.");
+      }
+      return makeFace.Face();
+   }
+
+   int CountFaces(const TopoDS_Shape& shape) {
+      TopTools_IndexedMapOfShape faces;
+      TopExp::MapShapes(shape, TopAbs_FACE, faces);
+      return faces.Extent();
+   }
+
+   // Volume enclosed by a closed mesh; negative when its triangles face inward
+   double SignedMeshVolume(const TopoDS_Shape& shape) {
+      MeshBVH bvh;
+      bvh.Build(shape);
+      double volume = 0;
+      for (const MeshBVH::Triangle& triangle : bvh.Triangles()) {
+         volume += triangle.p0.Dot(triangle.p1.Crossed(triangle.p2)) / 6.0;
+      }
+      return volume;
+   }
+
+   const char* KindName(SyntheticPartKind kind) {
+      switch (kind) {
+      case SyntheticPartKind::ExtrudedProfile: return "ExtrudedProfile";
+      case SyntheticPartKind::RevolvedFlex: return "RevolvedFlex";
+      }
+      return "Unknown";
+   }
+
+   // Wall-clock samples for one operation on one part
+   struct OperationTimes {
+      std::string name;
+      std::vector<double> ms;
+      std::string error;
+   };
+
+   template <typename Fn>
+   void TimeOperation(std::vector<OperationTimes>& ops, const std::string& name, Fn&& fn) {
+      auto it = std::find_if(ops.begin(), ops.end(), [&](const OperationTimes& o) { return o.name == name; });
+      if (it == ops.end()) {
+         ops.push_back({ name, {}, {} });
+         it = ops.end() - 1;
+      }
+      try {
+         auto start = std::chrono::steady_clock::now();
+         fn();
+         auto stop = std::chrono::steady_clock::now();
+         it->ms.push_back(std::chrono::duration<double, std::milli>(stop - start).count());
+      }
+      catch (const std::exception& ex) {
+         it->error = ex.what();
+      }
+   }
+
+   void WriteJsonString(std::ostream& out, const std::string& text) {
+      out << '"';
+      for (char c : text) {
+         switch (c) {
+         case '"': out << "\\\""; break;
+         case '\\': out << "\\\\"; break;
+         case '\n': out << "\\n"; break;
+         case '\r': out << "\\r"; break;
+         case '\t': out << "\\t"; break;
+         default: out << c; break;
+         }
+      }
+      out << '"';
+   }
+}
+
+TopoDS_Shape IGESBenchmark::GeneratePart(SyntheticPartKind kind, int targetFaces)
+{
+   std::vector<gp_Pnt> profile = CorrugatedProfile(RidgesForFaces(targetFaces));
+
+   TopoDS_Shape part;
+   if (kind == SyntheticPartKind::ExtrudedProfile) {
+      TopoDS_Face face = ProfileFace(profile, false);
+      part = BRepPrimAPI_MakePrism(face, gp_Vec(kPartLength, 0, 0)).Shape();
+   }
+   else {
+      TopoDS_Face face = ProfileFace(profile, true);
+      gp_Ax1 bendAxis(gp_Pnt(0, 0, -kBendRadius), gp_Dir(0, 1, 0));
+      part = BRepPrimAPI_MakeRevol(face, bendAxis, M_PI / 2.0).Shape();
+   }
+
+   return BRepBuilderAPI_Transform(part, PartTilt(), true).Shape();
+}
+
+int IGESBenchmark::WritePart(SyntheticPartKind kind, int targetFaces, const std::string& filePath)
+{
+   TopoDS_Shape part = GeneratePart(kind, targetFaces);
+
+   // BRep mode (1) writes an MSBO solid, so the part reads back as a solid
+   IGESHandler::InitTranslators();
+   IGESControl_Writer writer("MM", 1);
+   writer.AddShape(part);
+   writer.ComputeModel();
+   if (!writer.Write(filePath.c_str())) {
+      throw std::runtime_error("Failed to write synthetic IGES file: " + filePath);
+   }
+   return CountFaces(part);
+}
+
+std::vector<BenchmarkSample> IGESBenchmark::Run(const BenchmarkOptions& options)
+{
+   namespace fs = std::filesystem;
+   fs::create_directories(options.workDir);
+
+   std::vector<BenchmarkSample> samples;
+   for (SyntheticPartKind kind : { SyntheticPartKind::ExtrudedProfile, SyntheticPartKind::RevolvedFlex }) {
+      for (int targetFaces : options.faceCounts) {
+         std::string partName = std::string(KindName(kind)) + "_" + std::to_string(targetFaces);
+         std::string partPath = (fs::path(options.workDir) / (partName + ".igs")).string();
+         std::string savePath = (fs::path(options.workDir) / (partName + "_saved.igs")).string();
+         std::string fusedPath = (fs::path(options.workDir) / (partName + "_fused.igs")).string();
+
+         int faces = WritePart(kind, targetFaces, partPath);
+         std::cout << "Benchmarking " << partName << " (" << faces << " faces)" << std::endl;
+
+         std::vector<OperationTimes> ops;
+         // The flip tests run after alignment, so they are timed on the part squared to the axes
+         const TopoDS_Shape squared = BRepBuilderAPI_Transform(GeneratePart(kind, targetFaces), PartTilt().Inverted(), true).Shape();
+         Bnd_Box squaredBox;
+         BRepBndLib::Add(squared, squaredBox);
+         const gp_Pnt squaredCenter = (squaredBox.CornerMin().XYZ() + squaredBox.CornerMax().XYZ()) / 2.0;
+         for (int rep = 0; rep < options.repetitions; ++rep) {
+            // A fresh handler per repetition so that every operation sees the same input
+            IGESHandler handler;
+            TimeOperation(ops, "LoadIGES", [&] { handler.LoadIGES(partPath, 0); });
+            TimeOperation(ops, "AlignToXYPlane", [&] { handler.AlignToXYPlane(0); });
+            // The frame-based alignment modes on the same tilted part, each from a fresh load
+            for (auto [mode, name] : { std::make_pair(AlignmentMode::OrientedBox, "AlignToXYPlane/OrientedBox"),
+                                       std::make_pair(AlignmentMode::PCA, "AlignToXYPlane/PCA") }) {
+               IGESHandler alternative;
+               alternative.LoadIGES(partPath, 0);
+               TimeOperation(ops, name, [&] { alternative.AlignToXYPlane(0, mode); });
+            }
+            // Flip decision alone: the single exact ray against the ray-grid vote. The vote
+            // meshes the part, so each repetition gives it a fresh unmeshed copy.
+            TimeOperation(ops, "FlipTest/SingleRay", [&] {
+               gp_Pnt hit;
+               handler.DoesVectorIntersectShape(squared, squaredCenter, gp_Dir(0, 0, -1), hit);
+            });
+            const TopoDS_Shape unmeshed = BRepBuilderAPI_Copy(squared, Standard_True, Standard_False).Shape();
+            TimeOperation(ops, "FlipTest/RayGrid", [&] { IGESAlignment::ClassifyFlip(unmeshed); });
+            // The mirrored copy's meshes are the left part's put through the mirror; they must
+            // still enclose the same volume facing outward
+            handler.Mirror();
+            TimeOperation(ops, "MirrorLods", [&] {
+               const double left = SignedMeshVolume(handler.GetDetailedMesh(0));
+               const double mirrored = SignedMeshVolume(handler.GetDetailedMesh(3));
+               if (left <= 0 || std::abs(mirrored - left) > 0.01 * left) {
+                  throw std::runtime_error("Mirrored meshes enclose " + std::to_string(mirrored) + " against " + std::to_string(left));
+               }
+            });
+            TimeOperation(ops, "RotatePartBy180AboutZAxis", [&] { handler.RotatePartBy180AboutZAxis(0); });
+            TimeOperation(ops, "SaveIGES", [&] { handler.SaveIGES(savePath, 0); });
+            if (options.includeRender) {
+               TimeOperation(ops, "DumpInputShapes", [&] { handler.DumpInputShapes(options.renderWidth, options.renderHeight); });
+
+               // Picking on the persistent view: the first pick builds the BVH, the grid after
+               // it reuses it and is what the pointer costs; the target is under 1 ms
+               handler.RenderView(options.renderWidth, options.renderHeight, false);
+               handler.WaitForDetail(60000);
+               handler.EndInteraction();
+               TimeOperation(ops, "Pick/First", [&] { handler.Pick(options.renderWidth / 2, options.renderHeight / 2); });
+               for (int i = 0; i < 25; ++i) {
+                  const int x = options.renderWidth * (1 + i % 5) / 6;
+                  const int y = options.renderHeight * (1 + i / 5) / 6;
+                  TimeOperation(ops, "Pick", [&] { handler.Pick(x, y); });
+                  TimeOperation(ops, "Hover", [&] { handler.Hover(x, y); });
+               }
+            }
+            if (faces <= options.unionFaceLimit) {
+               TimeOperation(ops, "UnionShapes", [&] { handler.UnionShapes(); });
+               // The seam-local mode on a handler of its own, so it neither reuses the union
+               // above nor its cached mass properties. Both times include the interference
+               // test, the glue or heal, the validity check and the mass properties, which see
+               // the whole halves in either mode.
+               IGESHandler seamLocal;
+               seamLocal.LoadIGES(partPath, 0);
+               seamLocal.AlignToXYPlane(0);
+               seamLocal.SetUnionMode(UnionMode::SeamLocal);
+               TimeOperation(ops, "UnionShapes/SeamLocal", [&] { seamLocal.UnionShapes(); });
+               TimeOperation(ops, "SaveAsIGS", [&] { handler.SaveAsIGS(fusedPath); });
+               // The whole load-to-save union on several sessions at once; a time close to one
+               // UnionShapes run means the sessions do not contend
+               TimeOperation(ops, "SessionEngine/Union x" + std::to_string(options.concurrentSessions), [&] {
+                  IGESSessionEngine engine;
+                  std::vector<IGESSessionJob> jobs;
+                  for (int i = 0; i < options.concurrentSessions; ++i) {
+                     std::string resultPath = (fs::path(options.workDir) / (partName + "_fused_" + std::to_string(i) + ".igs")).string();
+                     jobs.push_back(engine.SubmitUnion(engine.OpenSession(), partPath, resultPath));
+                  }
+                  for (const IGESSessionJob& job : jobs) job.Get();
+               });
+               if (options.includeRender) {
+                  TimeOperation(ops, "DumpFusedShape", [&] { handler.DumpFusedShape(options.renderWidth, options.renderHeight); });
+               }
+            }
+         }
+
+         for (OperationTimes& op : ops) {
+            BenchmarkSample sample;
+            sample.part = partName;
+            sample.kind = KindName(kind);
+            sample.faces = faces;
+            sample.operation = op.name;
+            sample.runs = static_cast<int>(op.ms.size());
+            sample.error = op.error;
+            if (!op.ms.empty()) {
+               std::sort(op.ms.begin(), op.ms.end());
+               sample.minMs = op.ms.front();
+               sample.maxMs = op.ms.back();
+               sample.medianMs = op.ms[op.ms.size() / 2];
+               sample.meanMs = std::accumulate(op.ms.begin(), op.ms.end(), 0.0) / op.ms.size();
+            }
+            samples.push_back(sample);
+         }
+      }
+   }
+
+   if (!options.resultsPath.empty()) {
+      WriteResults(samples, options.resultsPath);
+   }
+   return samples;
+}
+
+void IGESBenchmark::WriteResults(const std::vector<BenchmarkSample>& samples, const std::string& filePath)
+{
+   std::ofstream out(filePath, std::ios::trunc);
+   if (!out) {
+      throw std::runtime_error("Failed to open benchmark results file: " + filePath);
+   }
+
+   std::time_t now = std::time(nullptr);
+   std::tm utc{};
+   gmtime_s(&utc, &now);
+
+   out << std::fixed << std::setprecision(3);
+   out << "{\n  \"schema\": \"prosmart-bench/1\",\n  \"timestamp\": \"" << std::put_time(&utc, "%Y-%m-%dT%H:%M:%SZ") << "\",\n";
+   out << "  \"occtVersion\": \"" << OCC_VERSION_COMPLETE << "\",\n";
+   out << "  \"hardwareThreads\": " << std::thread::hardware_concurrency() << ",\n";
+   out << "  \"samples\": [";
+   for (size_t i = 0; i < samples.size(); ++i) {
+      const BenchmarkSample& s = samples[i];
+      out << (i == 0 ? "\n" : ",\n") << "    {\"part\": ";
+      WriteJsonString(out, s.part);
+      out << ", \"kind\": ";
+      WriteJsonString(out, s.kind);
+      out << ", \"faces\": " << s.faces << ", \"operation\": ";
+      WriteJsonString(out, s.operation);
+      out << ", \"runs\": " << s.runs
+         << ", \"minMs\": " << s.minMs << ", \"medianMs\": " << s.medianMs
+         << ", \"meanMs\": " << s.meanMs << ", \"maxMs\": " << s.maxMs;
+      if (!s.error.empty()) {
+         out << ", \"error\": ";
+         WriteJsonString(out, s.error);
+      }
+      out << "}";
+   }
+   out << "\n  ]\n}\n";
+
+   std::cout << "Benchmark results written to: " << filePath << std::endl;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <string>
+#include <vector>
+
+class TopoDS_Shape;
+
+// Kinds of procedurally generated parts used by the benchmark suite
+enum class SyntheticPartKind
+{
+   ExtrudedProfile, // Corrugated sheet profile extruded along its length
+   RevolvedFlex     // Corrugated profile bent through 90 degrees (surfaces of revolution)
+};
+
+struct BenchmarkOptions
+{
+   std::string workDir;        // Generated parts and exported files are written here
+   std::string resultsPath;    // Machine-readable JSON results
+   std::vector<int> faceCounts = { 100, 1000, 10000, 50000 };
+   int repetitions = 3;
+   int unionFaceLimit = 10000; // Skip the Boolean pipeline on parts larger than this
+   int concurrentSessions = 4; // Unions run at once through IGESSessionEngine
+   bool includeRender = true;
+   int renderWidth = 800;
+   int renderHeight = 600;
+};
+
+struct BenchmarkSample
+{
+   std::string part;
+   std::string kind;
+   int faces = 0;
+   std::string operation;
+   int runs = 0;
+   double minMs = 0, medianMs = 0, meanMs = 0, maxMs = 0;
+   std::string error;
+};
+
+// Reproducible geometry benchmarks for the IGESHandler pipeline
+class IGESBenchmark
+{
+public:
+   // Build a solid of the given kind with roughly targetFaces faces.
+   // The geometry depends only on the arguments, so runs are comparable.
+   static TopoDS_Shape GeneratePart(SyntheticPartKind kind, int targetFaces);
+
+   // Generate a part and write it as an IGES solid. Returns the actual face count.
+   static int WritePart(SyntheticPartKind kind, int targetFaces, const std::string& filePath);
+
+   // Time load, align, rotate, union, save and render for every kind and face count,
+   // and write the results to options.resultsPath
+   static std::vector<BenchmarkSample> Run(const BenchmarkOptions& options);
+
+   static void WriteResults(const std::vector<BenchmarkSample>& samples, const std::string& filePath);
+};
@@ -0,0 +1,71 @@
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include "IGESExportJob.h"
+
+class IGESExportJob_PIMPL
+{
+public:
+   std::shared_future<std::vector<unsigned char>> mResult;
+   std::mutex mMutex;
+   bool mReady = false;
+   std::vector<std::function<void()>> mCallbacks; // Run once, when the result is set
+};
+
+IGESExportJob IGESExportJob::Start(std::function<std::vector<unsigned char>()> work)
+{
+   IGESExportJob job;
+   job.mpPimpl = std::make_shared<IGESExportJob_PIMPL>();
+   auto promise = std::make_shared<std::promise<std::vector<unsigned char>>>();
+   job.mpPimpl->mResult = promise->get_future().share();
+   // Detached: the thread keeps the job state alive until the callbacks have run
+   std::thread([pimpl = job.mpPimpl, promise, work = std::move(work)]() {
+      try {
+         promise->set_value(work());
+      }
+      catch (...) {
+         promise->set_exception(std::current_exception());
+      }
+      std::vector<std::function<void()>> callbacks;
+      {
+         std::lock_guard<std::mutex> lock(pimpl->mMutex);
+         pimpl->mReady = true;
+         callbacks.swap(pimpl->mCallbacks);
+      }
+      for (const std::function<void()>& callback : callbacks) callback();
+   }).detach();
+   return job;
+}
+
+void IGESExportJob::OnReady(std::function<void()> done) const
+{
+   if (!mpPimpl) throw std::runtime_error("No export job was started.");
+   {
+      std::lock_guard<std::mutex> lock(mpPimpl->mMutex);
+      if (!mpPimpl->mReady) {
+         mpPimpl->mCallbacks.push_back(std::move(done));
+         return;
+      }
+   }
+   done();
+}
+
+bool IGESExportJob::IsReady() const
+{
+   if (!mpPimpl) return false;
+   return mpPimpl->mResult.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+void IGESExportJob::Wait() const
+{
+   if (!mpPimpl) throw std::runtime_error("No export job was started.");
+   mpPimpl->mResult.wait();
+}
+
+std::vector<unsigned char> IGESExportJob::Get() const
+{
+   if (!mpPimpl) throw std::runtime_error("No export job was started.");
+   return mpPimpl->mResult.get();
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <vector>
+
+class IGESExportJob_PIMPL;
+
+// Handle to an export serializing a shape into memory on a background thread.
+// Copies share the same result. The header stays free of <future> so the /clr
+// wrapper can include it.
+class IGESExportJob
+{
+public:
+   IGESExportJob() = default;
+
+   // Run work on a new thread and return a handle to its result
+   static IGESExportJob Start(std::function<std::vector<unsigned char>()> work);
+
+   bool IsValid() const { return mpPimpl != nullptr; }
+
+   // True once the bytes (or the error) are available
+   bool IsReady() const;
+
+   void Wait() const;
+
+   // Call done on the export thread once the bytes (or the error) are available, or at once
+   // if they already are, so nothing has to block waiting for the job. done must not throw.
+   void OnReady(std::function<void()> done) const;
+
+   // Block until the export finishes; rethrows the exception the export failed with
+   std::vector<unsigned char> Get() const;
+
+private:
+   std::shared_ptr<IGESExportJob_PIMPL> mpPimpl;
+};
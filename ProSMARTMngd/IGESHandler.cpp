@@ -3,18 +3,57 @@
 #include <vector>
 #include <algorithm>
 #include <map>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <cctype>
+#include <future>
+#include <thread>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <atomic>
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
 #include <gp_Ax1.hxx>
 #include <BRepAlgoAPI_Fuse.hxx>
+#include <BRepAlgoAPI_Splitter.hxx>
+#include <BRepBuilderAPI_MakeFace.hxx>
+#include <gp_Pln.hxx>
+#include <BOPAlgo_PaveFiller.hxx>
+#include <NCollection_IncAllocator.hxx>
 #include <BRepBuilderAPI_Transform.hxx>
 #include <BRepBndLib.hxx>
+#include <BRepAdaptor_Surface.hxx>
 #include <BRepTools.hxx>
 #include <gp_Trsf.hxx>
 #include <gp_Vec.hxx>
 #include <Graphic3d_Mat4.hxx>
 #include <IGESControl_Reader.hxx>
+#include <Standard_Failure.hxx>
 #include <IGESControl_Writer.hxx>
+#include <STEPControl_Reader.hxx>
+#include <STEPControl_Writer.hxx>
+#include <IFSelect_ReturnStatus.hxx>
+#include <IGESControl_Controller.hxx>
+#include <STEPControl_Controller.hxx>
+#include <StlAPI_Writer.hxx>
+#include <BRepMesh_IncrementalMesh.hxx>
+#include <BinTools.hxx>
+#include <BRepBuilderAPI_Copy.hxx>
+#include <Prs3d_Drawer.hxx>
+#include <Poly_Triangulation.hxx>
+#include <NCollection_DataMap.hxx>
+#include <TopTools_OrientedShapeMapHasher.hxx>
+#include <TopTools_ListOfShape.hxx>
+#include <Poly_PolygonOnTriangulation.hxx>
+#include <TopoDS_Edge.hxx>
 #include <TopoDS_Shape.hxx>
 #include <Bnd_Box.hxx>
+#include <TopTools_MapOfShape.hxx>
 #include <V3d_Viewer.hxx>
 #include <V3d_View.hxx>
 #include <AIS_Shape.hxx>
@@ -57,8 +96,20 @@
 #include <GeomAbs_SurfaceType.hxx>
 #include <Geom_SurfaceOfRevolution.hxx>
 #include <GeomLProp_SurfaceTool.hxx>
+#include <Message_ProgressIndicator.hxx>
+#include <Message_ProgressScope.hxx>
+#include <Precision.hxx>
 
 #include "IGESHandler.h"
+#include "IGESTrace.h"
+#include "IGESScanner.h"
+#include "MappedFile.h"
+#include "MeshBVH.h"
+#include "IGESMassProperties.h"
+#include "IGESInterference.h"
+#include "IGESSlicer.h"
+#include "FaceBoxIndex.h"
+#include "IGESAlignment.h"
 
 
 
@@ -210,16 +261,218 @@ TopoDS_Shape processRevolutions(const TopoDS_Shape& shape, double tolerance = 1e
    return unify.Shape();
 }
 
+// The IGES and STEP translators keep their parameters and work sessions in process-wide
+// tables, so readers and writers of those formats take turns
+std::mutex& TranslatorMutex() {
+   static std::mutex mutex;
+   return mutex;
+}
+
+// Serialize a shape into an in-memory IGES, STEP or BRep file
+std::vector<unsigned char> WriteShapeToMemory(const TopoDS_Shape& shape, ShapeFormat format) {
+   PROSMART_TRACE_SCOPE("WriteShapeToMemory");
+   std::ostringstream stream(std::ios::out | std::ios::binary);
+   switch (format) {
+   case ShapeFormat::IGES: {
+      std::lock_guard<std::mutex> lock(TranslatorMutex());
+      IGESControl_Writer writer;
+      writer.AddShape(shape);
+      if (!writer.Write(stream)) {
+         throw std::runtime_error("Failed to write IGES data.");
+      }
+      break;
+   }
+   case ShapeFormat::STEP: {
+      std::lock_guard<std::mutex> lock(TranslatorMutex());
+      STEPControl_Writer writer;
+      if (writer.Transfer(shape, STEPControl_AsIs) != IFSelect_RetDone) {
+         throw std::runtime_error("Failed to translate shape to STEP.");
+      }
+      if (writer.WriteStream(stream) != IFSelect_RetDone) {
+         throw std::runtime_error("Failed to write STEP data.");
+      }
+      break;
+   }
+   case ShapeFormat::BRep:
+      BRepTools::Write(shape, stream);
+      break;
+   default:
+      throw std::runtime_error("Unsupported export format.");
+   }
+   const std::string data = stream.str();
+   return std::vector<unsigned char>(data.begin(), data.end());
+}
+
+// Lets a background union be abandoned; the Boolean polls it as it goes
+class UnionCancelFlag : public Message_ProgressIndicator {
+public:
+   void Cancel() { mCancelled = true; }
+   Standard_Boolean UserBreak() override { return mCancelled; }
+
+protected:
+   void Show(const Message_ProgressScope&, const Standard_Boolean) override {}
+
+private:
+   std::atomic<bool> mCancelled{ false };
+};
+
+// Runs the calling thread below normal priority; restored after, as async threads are pooled
+struct LowPriorityScope {
+   LowPriorityScope() : previous(GetThreadPriority(GetCurrentThread())) {
+      SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+   }
+   ~LowPriorityScope() { SetThreadPriority(GetCurrentThread(), previous); }
+   int previous;
+};
+
+// Tolerances one union attempt runs with
+struct UnionTolerances {
+   double fuzzy = 0;                // Boolean fuzzy value; 0 for an exact Boolean
+   double sewing = 1e-2;            // Sewing of the fuse result
+   double fixPrecision = 1e-3;      // ShapeFix_Shape precision
+};
+
+// One union attempt and how it ended
+struct UnionAttempt {
+   UnionTolerances tolerances;
+   TopoDS_Shape fused;
+   bool valid = false;
+   bool multipleSolids = false;
+   std::string failure;             // Empty when the result is one valid solid
+   double seconds = 0;
+};
+
+// A part united with its mirrored copy, not yet stored in any slot
+struct UnionOutcome {
+   TopoDS_Shape mirrored;
+   TopoDS_Shape fused;
+   bool valid = false;              // BRepCheck verdict on the fused shape
+   bool multipleSolids = false;
+   gp_Trsf mirrorTrsf;              // Takes the left part onto mirrored
+   MassPropertiesReport leftReport, mirroredReport;
+   std::string tolerances;          // Every attempt, its tolerances and how it ended
+   double seconds = 0;
+};
+
 class IGESHandler_PIMPL {
    private:
    Handle(V3d_Viewer) viewer; // Open CASCADE viewer
    Handle(AIS_InteractiveContext) context; // AIS Context14
-   BRepAlgoAPI_Fuse mFuser;
-   TopoDS_Shape mShapeLeft, mShapeRight, mFusedShape;
+   std::map<ShapeFormat, FormatTimings> mFormatTimings;
+
+   // Persistent offscreen view for camera-only re-renders
+   Handle(V3d_Viewer) mInteractiveViewer;
+   Handle(AIS_InteractiveContext) mInteractiveContext;
+   Handle(V3d_View) mInteractiveView;
+   Handle(Aspect_NeutralWindow) mInteractiveWindow;
+   Image_AlienPixMap mFrame;           // Reused between frames
+   bool mSceneValid = false, mSceneFused = false;
+   std::uint64_t mSceneGeneration[2] = {}; // Generations of the shapes currently displayed
+   int mSceneLevel[2] = { -1, -1 };        // Level of detail shown for each displayed shape
+
+   // Tessellated copies of one slot's shape, coarse first, meshed on background threads
+   struct ShapeLods {
+      std::uint64_t generation = 0;
+      std::vector<std::shared_future<TopoDS_Shape>> levels;
+   };
+   static constexpr int kLodCount = 3;
+   std::vector<std::shared_future<TopoDS_Shape>> mRetiredLods; // Outdated jobs still running
+   std::mutex mLodMutex;
+   bool mInteracting = false;
+
+   // Records that a slot's shape is another slot's shape put through a rigid or mirror
+   // transform, so data derived from the source can be transformed instead of recomputed.
+   // This spares the mirrored half's own check, box, meshes and mass integration only; the
+   // fused result after the Boolean is still healed, checked and integrated whole.
+   struct SlotSymmetry {
+      std::string source;
+      std::uint64_t generation = 0;     // Source generation the image was made from
+      gp_Trsf trsf;
+   };
+
+   // A named shape with the data derived from it. The derived data belongs to one
+   // generation of the shape and is dropped whenever the shape is replaced.
+   struct ShapeSlot {
+      TopoDS_Shape shape;
+      ShapeFormat format = ShapeFormat::Unknown;
+      gp_Trsf placement;                // Accumulated align/rotate transform since the load
+      std::uint64_t generation = 0;     // Unique across slots, bumped whenever the shape changes
+      std::optional<Bnd_Box> box;
+      std::optional<bool> valid;
+      ShapeLods lods;                   // Guarded by mLodMutex
+      std::shared_ptr<const FaceBoxIndex> faceBoxes;
+      std::optional<SlotSymmetry> symmetry;
+   };
+   // mSlotMutex guards the map itself, so background work can look slots up while one is
+   // added or removed; a slot's lods are guarded by mLodMutex, taken first when both are.
+   // Lookups share ownership of the slot, so one removed meanwhile stays alive for its users.
+   std::map<std::string, std::shared_ptr<ShapeSlot>> mSlots;
+   mutable std::mutex mSlotMutex;
+   std::uint64_t mLastGeneration = 0;
+
+   // Last successful union, kept so a part that has only moved rigidly is not united again
+   struct UnionCache {
+      TopoDS_Shape left;                // Left part as united
+      std::uint64_t generation = 0;     // Its slot generation then
+      gp_Trsf placement;                // Its placement then
+      double mirrorX = 0;               // Mirror plane of that union
+      UnionMode mode = UnionMode::Full;
+      TopoDS_Shape mirrored;
+      TopoDS_Shape fused;               // Healed and validated
+   };
+   std::optional<UnionCache> mUnionCache;
+
+   // Picking works on the meshes actually on screen. A BVH is built once per displayed
+   // level-of-detail copy, so moving between levels or redisplaying reuses it.
+   struct PickIndex {
+      TopoDS_Shape shape;
+      MeshBVH bvh;
+      TopTools_IndexedMapOfShape edges;
+   };
+   TopoDS_Shape mSceneShapes[2];            // Displayed level-of-detail copies
+   std::string mSceneSlots[2];              // Slot each displayed shape came from
+   std::shared_ptr<PickIndex> mPickIndex[2];           // Looked up on the first pick after the scene changes
+   std::vector<std::shared_ptr<PickIndex>> mPickCache; // Recently displayed copies, newest last
+   static constexpr std::size_t kPickCacheSize = 8;    // Every level of two slots, with some slack
+   Handle(AIS_Shape) mHighlight;            // Face selected with HighlightFace
+   Handle(AIS_Shape) mHoverHighlight;       // Face under the pointer
+   std::string mHoverSlot;
+   int mHoverFace = 0;
+
+   // Mass properties by shape, so repeated reports on an unchanged shape are free
+   NCollection_DataMap<TopoDS_Shape, MassPropertiesReport, TopTools_OrientedShapeMapHasher> mMassCache;
+   std::mutex mMassMutex;
+   static constexpr int kMassCacheSize = 16;
+
+   FlipTest mFlipTest = FlipTest::SingleRay;
+   Handle(NCollection_IncAllocator) mArena = MakeArena();
+
+   // Union started in the background once the left part is aligned. Declared after the
+   // mass cache it uses, so the futures are waited for before it goes.
+   struct SpeculativeUnion {
+      std::uint64_t generation = 0;     // Left slot generation it started from
+      UnionMode mode = UnionMode::Full;
+      Handle(UnionCancelFlag) cancel;
+      std::shared_future<void> copied;  // Ready once the worker no longer reads the left part
+      std::future<UnionOutcome> outcome;
+   };
+   static constexpr std::chrono::milliseconds kSpeculationDelay{ 300 }; // Quiet time before a speculation starts
+   bool mSpeculate = false;
+   UnionMode mUnionMode = UnionMode::Full;
+   static constexpr double kSeamOverlap = 0.9; // The mirrored half overlaps the left one by this in X
+   static constexpr std::size_t kMaxCandidates = 2; // Escalated unions at once, each on full copies of the halves
+   std::optional<SpeculativeUnion> mSpeculation;
+   std::vector<std::future<UnionOutcome>> mRetiredSpeculations; // Cancelled, possibly still running
+
+   // Each arena serves one operation at a time. It takes no lock until a parallel Boolean
+   // asks for one (FuseHalves).
+   static Handle(NCollection_IncAllocator) MakeArena() {
+      return new NCollection_IncAllocator();
+   }
 
    public:
    IGESHandler_PIMPL() = default;
-   ~IGESHandler_PIMPL() {}
+   ~IGESHandler_PIMPL() { CancelSpeculation(); }
 
    // Constructor to initialize with a viewer
    explicit IGESHandler_PIMPL(const Handle(V3d_Viewer)& aViewer) : viewer(aViewer) {}
@@ -244,45 +497,872 @@ class IGESHandler_PIMPL {
       return viewer->ActiveViews();
    }
 
-   void SetFuser(const BRepAlgoAPI_Fuse& fuser) {
-      mFuser = fuser;
+   // Scratch memory of the session: the Boolean data structure and temporary topology maps
+   // of an operation are carved from it and dropped together when the operation returns
+   Handle(NCollection_IncAllocator) GetArena() const {
+      return mArena;
    }
 
-   BRepAlgoAPI_Fuse GetFuser() {
-      return mFuser;
+   // Rewinds the arena when the operation that uses it returns or throws. Everything
+   // allocated from it must be gone by then.
+   struct ArenaScope {
+      Handle(NCollection_IncAllocator) arena;
+      ~ArenaScope() { arena->Reset(false); } // Keeps the blocks for the next operation
+   };
+
+   // Slot access by id; a missing slot reads as empty
+   std::shared_ptr<const ShapeSlot> FindSlot(const std::string& id) const {
+      std::lock_guard<std::mutex> lock(mSlotMutex);
+      auto it = mSlots.find(id);
+      return it == mSlots.end() ? nullptr : it->second;
+   }
+
+   std::shared_ptr<ShapeSlot> GetSlot(const std::string& id) {
+      std::lock_guard<std::mutex> lock(mSlotMutex);
+      auto it = mSlots.find(id);
+      if (it == mSlots.end()) throw std::runtime_error("No shape slot named " + id + ".");
+      return it->second;
+   }
+
+   // The slot, added empty if missing
+   std::shared_ptr<ShapeSlot> AddSlot(const std::string& id) {
+      std::lock_guard<std::mutex> lock(mSlotMutex);
+      std::shared_ptr<ShapeSlot>& slot = mSlots[id];
+      if (!slot) slot = std::make_shared<ShapeSlot>();
+      return slot;
+   }
+
+   // Replacing the shape keeps the format and placement and drops everything derived from it
+   void SetSlotShape(const std::string& id, const TopoDS_Shape& shape) {
+      if (id == IGESHandler::SlotId(0)) CancelSpeculation(); // It was uniting the old part
+      const std::shared_ptr<ShapeSlot> slot = AddSlot(id);
+      slot->shape = shape;
+      slot->generation = ++mLastGeneration;
+      slot->box.reset();
+      slot->valid.reset();
+      slot->faceBoxes.reset();
+      slot->symmetry.reset();
+   }
+
+   // The slot a symmetric image was made from, while that slot still holds the same shape
+   std::shared_ptr<const ShapeSlot> SymmetrySource(const ShapeSlot& slot) const {
+      if (!slot.symmetry) return nullptr;
+      std::shared_ptr<const ShapeSlot> source = FindSlot(slot.symmetry->source);
+      return source != nullptr && source->generation == slot.symmetry->generation ? source : nullptr;
+   }
+
+   // A copy of the handle, so it stays valid whatever happens to the slot afterwards
+   TopoDS_Shape GetSlotShape(const std::string& id) const {
+      const std::shared_ptr<const ShapeSlot> slot = FindSlot(id);
+      return slot != nullptr ? slot->shape : TopoDS_Shape();
+   }
+
+   TopoDS_Shape GetSlotShape(int order) const {
+      return GetSlotShape(IGESHandler::SlotId(order));
+   }
+
+   // A freshly loaded part starts from its file placement
+   void SetLoadedShape(const std::string& id, const TopoDS_Shape& shape, ShapeFormat format) {
+      SetSlotShape(id, shape);
+      SetSourceFormat(id, format);
+   }
+
+   void RemoveSlot(const std::string& id) {
+      if (FindSlot(id) == nullptr) return;
+      if (id == IGESHandler::SlotId(0)) CancelSpeculation();
+      mUnionCache.reset(); // It may describe the removed slot's shape
+      std::lock_guard<std::mutex> lock(mLodMutex);
+      std::lock_guard<std::mutex> slotLock(mSlotMutex);
+      auto it = mSlots.find(id);
+      if (it == mSlots.end()) return;
+      // A std::async future blocks in its destructor; park the slot's jobs until they finish
+      ShapeLods& lods = it->second->lods;
+      mRetiredLods.insert(mRetiredLods.end(), lods.levels.begin(), lods.levels.end());
+      mSlots.erase(it);
+   }
+
+   std::vector<std::string> GetSlotIds() const {
+      std::lock_guard<std::mutex> lock(mSlotMutex);
+      std::vector<std::string> ids;
+      for (const auto& [id, slot] : mSlots) ids.push_back(id);
+      return ids;
+   }
+
+   Bnd_Box GetSlotBox(const std::string& id) {
+      const std::shared_ptr<ShapeSlot> slot = GetSlot(id);
+      if (!slot->box) {
+         if (SymmetrySource(*slot) != nullptr) {
+            slot->box = GetSlotBox(slot->symmetry->source).Transformed(slot->symmetry->trsf);
+         }
+         else {
+            slot->box.emplace();
+            if (!slot->shape.IsNull()) BRepBndLib::Add(slot->shape, *slot->box);
+         }
+      }
+      return *slot->box;
+   }
+
+   bool IsSlotValid(const std::string& id) {
+      const std::shared_ptr<ShapeSlot> slot = GetSlot(id);
+      if (!slot->valid && SymmetrySource(*slot) != nullptr) {
+         slot->valid = !slot->shape.IsNull() && IsSlotValid(slot->symmetry->source); // An image is as valid as its source
+      }
+      if (!slot->valid) {
+         PROSMART_TRACE_SCOPE("CheckSlotValidity");
+         slot->valid = !slot->shape.IsNull() && BRepCheck_Analyzer(slot->shape).IsValid();
+      }
+      return *slot->valid;
    }
 
    void SetLeftShape(const TopoDS_Shape& shape) {
-      mShapeLeft = shape;
+      SetSlotShape(IGESHandler::SlotId(0), shape);
    }
 
    TopoDS_Shape GetLeftShape() {
-      return mShapeLeft;
+      return GetSlotShape(0);
    }
 
 
    void SetRightShape(const TopoDS_Shape& shape) {
-      mShapeRight = shape;
+      SetSlotShape(IGESHandler::SlotId(1), shape);
    }
 
    TopoDS_Shape GetRightShape() {
-      return mShapeRight;
+      return GetSlotShape(1);
    }
 
    void SetFusedShape(const TopoDS_Shape& shape) {
-      mFusedShape = shape;
+      SetSlotShape(IGESHandler::SlotId(2), shape);
+   }
+
+   void SetSourceFormat(const std::string& id, ShapeFormat format) {
+      const std::shared_ptr<ShapeSlot> slot = AddSlot(id);
+      slot->format = format;
+      slot->placement = gp_Trsf();
+   }
+
+   // Compose a transform applied to a part onto its placement
+   void ApplyPlacement(int order, const gp_Trsf& trsf) {
+      const std::shared_ptr<ShapeSlot> slot = AddSlot(IGESHandler::SlotId(order));
+      slot->placement = trsf * slot->placement;
+   }
+
+   gp_Trsf GetPlacement(const std::string& id) const {
+      const std::shared_ptr<const ShapeSlot> slot = FindSlot(id);
+      return slot != nullptr ? slot->placement : gp_Trsf();
+   }
+
+   void SetPlacement(const std::string& id, const gp_Trsf& trsf) {
+      AddSlot(id)->placement = trsf;
+   }
+
+   std::uint64_t GetGeneration(const std::string& id) const {
+      const std::shared_ptr<const ShapeSlot> slot = FindSlot(id);
+      return slot != nullptr ? slot->generation : 0;
+   }
+
+   // A restored slot keeps its saved generation; generations handed out later stay above it
+   void RestoreGeneration(const std::string& id, std::uint64_t generation) {
+      GetSlot(id)->generation = generation;
+      mLastGeneration = std::max(mLastGeneration, generation);
+   }
+
+   // Restored generations may equal ones the union cache and the view saw for other
+   // shapes, so neither may be trusted afterwards
+   void ForgetGenerations() {
+      mUnionCache.reset();
+      mSceneValid = false;
+   }
+
+   // Drop what was computed from a shape that an operation has changed in place
+   void InvalidateSlotShape(const std::string& id) {
+      const std::shared_ptr<ShapeSlot> slot = GetSlot(id);
+      slot->box.reset();
+      slot->valid.reset();
+      slot->faceBoxes.reset();
+   }
+
+   ShapeFormat GetSourceFormat(const std::string& id) const {
+      const std::shared_ptr<const ShapeSlot> slot = FindSlot(id);
+      return slot != nullptr ? slot->format : ShapeFormat::Unknown;
+   }
+
+   ShapeFormat GetSourceFormat(int order) const {
+      return GetSourceFormat(IGESHandler::SlotId(order));
+   }
+
+   void RecordLoadTime(ShapeFormat format, double seconds) {
+      FormatTimings& timings = mFormatTimings[format];
+      timings.format = format;
+      ++timings.loads;
+      timings.loadSeconds += seconds;
+   }
+
+   void RecordUnionTime(ShapeFormat format, double seconds) {
+      FormatTimings& timings = mFormatTimings[format];
+      timings.format = format;
+      ++timings.unions;
+      timings.unionSeconds += seconds;
+   }
+
+   std::vector<FormatTimings> GetFormatTimings() const {
+      std::vector<FormatTimings> result;
+      for (const auto& [format, timings] : mFormatTimings) result.push_back(timings);
+      return result;
    }
 
    TopoDS_Shape GetFusedShape() {
-      return mFusedShape;
+      return GetSlotShape(2);
    }
 
+   // The mirrored copy has a slot of its own, so mirroring leaves the last union alone
    void SetMirroredShape(const TopoDS_Shape& shape) {
-      mFusedShape = shape;
+      SetSlotShape(IGESHandler::SlotId(3), shape);
    }
 
    TopoDS_Shape GetMirroredShape() {
-      return mFusedShape;
+      return GetSlotShape(3);
+   }
+
+   // The mirrored slot, recorded as the image of the left part under trsf
+   void SetMirroredImage(const TopoDS_Shape& shape, const gp_Trsf& trsf) {
+      const std::string leftId = IGESHandler::SlotId(0);
+      SetMirroredShape(shape);
+      GetSlot(IGESHandler::SlotId(3))->symmetry = SlotSymmetry{ leftId, GetGeneration(leftId), trsf };
+   }
+
+   void CacheUnion() {
+      const std::shared_ptr<const ShapeSlot> left = GetSlot(IGESHandler::SlotId(0));
+      UnionCache cache;
+      cache.left = left->shape;
+      cache.generation = left->generation;
+      cache.placement = left->placement;
+      cache.mirrorX = std::get<3>(GetBBoxComp(left->shape));
+      cache.mode = mUnionMode;
+      cache.mirrored = GetMirroredShape();
+      cache.fused = GetFusedShape();
+      mUnionCache = std::move(cache);
+   }
+
+   // Reflection across x = c commutes with a rigid motion that keeps the X axis, which moves
+   // the plane to c plus the motion's X shift. For such a motion the union of the moved part
+   // is the previous union moved the same way, so the Boolean and the heal can be skipped.
+   bool ReuseUnion() {
+      if (!mUnionCache || mUnionCache->mode != mUnionMode) return false;
+      const std::shared_ptr<const ShapeSlot> left = FindSlot(IGESHandler::SlotId(0));
+      if (left == nullptr || left->shape.IsNull()) return false;
+
+      gp_Trsf motion;
+      if (left->generation != mUnionCache->generation) {
+         motion = left->placement * mUnionCache->placement.Inverted();
+         if (motion.IsNegative() || std::abs(motion.ScaleFactor() - 1.0) > Precision::Confusion()) return false;
+         if (!gp_Dir(1, 0, 0).Transformed(motion).IsEqual(gp_Dir(1, 0, 0), Precision::Angular())) return false;
+         // The placements say how the part moved; its vertices confirm nothing else changed
+         if (!MovedRigidly(mUnionCache->left, left->shape, motion)) return false;
+         auto [xmin, ymin, zmin, xmax, ymax, zmax] = GetBBoxComp(left->shape);
+         const double tolerance = Precision::Confusion() + 1e-9 * (xmax - xmin);
+         if (std::abs(xmax - (mUnionCache->mirrorX + motion.TranslationPart().X())) > tolerance) return false;
+      }
+
+      // Moved by location, so the healed geometry is shared rather than copied
+      const TopLoc_Location location(motion);
+      const TopoDS_Shape mirrored = mUnionCache->mirrored.Moved(location);
+      const TopoDS_Shape fused = mUnionCache->fused.Moved(location);
+      SetMirroredImage(mirrored, MirrorTrsf(left->shape));
+      SetFusedShape(fused);
+      GetSlot(IGESHandler::SlotId(2))->valid = true;
+
+      // Later moves are measured from here
+      mUnionCache->left = left->shape;
+      mUnionCache->generation = left->generation;
+      mUnionCache->placement = left->placement;
+      mUnionCache->mirrorX += motion.TranslationPart().X();
+      mUnionCache->mirrored = mirrored;
+      mUnionCache->fused = fused;
+      return true;
+   }
+
+   // Same number of vertices, each vertex of from landing on its counterpart in to
+   // Vertices alone miss a face whose surface changed inside fixed edges, so every face must
+   // also share its TShape with the old one, or have the same surface type and the moved
+   // point at the middle of its parameter range
+   static bool MovedRigidly(const TopoDS_Shape& from, const TopoDS_Shape& to, const gp_Trsf& motion) {
+      TopTools_IndexedMapOfShape fromVertices, toVertices;
+      TopExp::MapShapes(from, TopAbs_VERTEX, fromVertices);
+      TopExp::MapShapes(to, TopAbs_VERTEX, toVertices);
+      if (fromVertices.Extent() == 0 || fromVertices.Extent() != toVertices.Extent()) return false;
+      for (int i = 1; i <= fromVertices.Extent(); ++i) {
+         const gp_Pnt moved = BRep_Tool::Pnt(TopoDS::Vertex(fromVertices(i))).Transformed(motion);
+         if (moved.Distance(BRep_Tool::Pnt(TopoDS::Vertex(toVertices(i)))) > Precision::Confusion()) return false;
+      }
+
+      TopTools_IndexedMapOfShape fromFaces, toFaces;
+      TopExp::MapShapes(from, TopAbs_FACE, fromFaces);
+      TopExp::MapShapes(to, TopAbs_FACE, toFaces);
+      if (fromFaces.Extent() != toFaces.Extent()) return false;
+      for (int i = 1; i <= fromFaces.Extent(); ++i) {
+         const TopoDS_Face& fromFace = TopoDS::Face(fromFaces(i));
+         const TopoDS_Face& toFace = TopoDS::Face(toFaces(i));
+         if (fromFace.TShape() == toFace.TShape()) continue;
+         const BRepAdaptor_Surface fromSurface(fromFace, Standard_False), toSurface(toFace, Standard_False);
+         if (fromSurface.GetType() != toSurface.GetType()) return false;
+         double u1, u2, v1, v2;
+         BRepTools::UVBounds(fromFace, u1, u2, v1, v2);
+         const gp_Pnt moved = fromSurface.Value((u1 + u2) / 2.0, (v1 + v2) / 2.0).Transformed(motion);
+         if (moved.Distance(toSurface.Value((u1 + u2) / 2.0, (v1 + v2) / 2.0)) > Precision::Confusion()) return false;
+      }
+      return true;
+   }
+
+   // Mirror across the plane through the part's largest X, then overlap by 0.9 for the seam
+   gp_Trsf MirrorTrsf(const TopoDS_Shape& leftShape) {
+      // Compute the bounding box of the left shape
+      auto [xmin, ymin, zmin, xmax, ymax, zmax] = GetBBoxComp(leftShape);
+
+      // Define the mirror plane passing through (xmax, ymax, zmax) with normal (-1, 0, 0)
+      gp_Pnt planePoint(xmax, ymax, zmax);
+      gp_Dir planeNormal(-1, 0, 0);
+      gp_Ax2 mirrorPlane(planePoint, planeNormal);
+
+      // Create a transformation for mirroring
+      gp_Trsf mirrorTransformation;
+      mirrorTransformation.SetMirror(mirrorPlane);
+
+      gp_Trsf overlapTransformation;
+      overlapTransformation.SetTranslation(gp_Vec(-kSeamOverlap, 0, 0));
+      return overlapTransformation * mirrorTransformation;
+   }
+
+   TopoDS_Shape MirrorShape(const TopoDS_Shape& leftShape, gp_Trsf& trsf) {
+      PROSMART_TRACE_SCOPE("Mirror");
+      if (leftShape.IsNull()) {
+         throw std::runtime_error("Left shape is null or not loaded.");
+      }
+
+      // Apply the mirroring transformation to the left shape
+      trsf = MirrorTrsf(leftShape);
+      BRepBuilderAPI_Transform mirroringTransform(leftShape, trsf, true);
+      TopoDS_Shape mirroredShape = mirroringTransform.Shape();
+
+      if (mirroredShape.IsNull()) {
+         throw std::runtime_error("Failed to create mirrored shape.");
+      }
+      return mirroredShape;
+   }
+
+   // The exact Boolean of two overlapping pieces, followed by the heal
+   TopoDS_Shape FuseHalves(IGESHandler& handler, const TopoDS_Shape& left, const TopoDS_Shape& mirrored, bool sewFaces,
+      const Handle(NCollection_IncAllocator)& arena, bool runParallel, const UnionTolerances& tolerances, const Message_ProgressRange& range) {
+      Message_ProgressScope progress(range, "FuseHalves", 2);
+
+      // The intersection data structure, the bulk of the Boolean's allocations, and the fuse
+      // built on it live in the arena. A parallel Boolean's threads share it, so it is locked.
+      PROSMART_TRACE_SPAN(fuseSpan, "UnionShapes/Fuse");
+      arena->SetThreadSafe(runParallel);
+      BOPAlgo_PaveFiller paveFiller(arena);
+      TopTools_ListOfShape arguments;
+      arguments.Append(left);
+      arguments.Append(mirrored);
+      paveFiller.SetArguments(arguments);
+      paveFiller.SetRunParallel(runParallel);
+      // Tolerances are widened on copies, so a failed attempt leaves the halves as they were
+      paveFiller.SetNonDestructive(Standard_True);
+      if (tolerances.fuzzy > 0) {
+         // Faces that only touch, or miss by a gap, are merged instead of left as a slit
+         paveFiller.SetFuzzyValue(tolerances.fuzzy);
+      }
+      paveFiller.Perform(progress.Next());
+      if (progress.UserBreak()) {
+         throw std::runtime_error("The union was cancelled.");
+      }
+      if (paveFiller.HasErrors()) {
+         throw std::runtime_error("Intersection of the parts failed.");
+      }
+      BRepAlgoAPI_Fuse fuser(left, mirrored, paveFiller, progress.Next());
+      PROSMART_TRACE_STOP(fuseSpan);
+      if (progress.UserBreak()) {
+         throw std::runtime_error("The union was cancelled.");
+      }
+
+      // Validate the fuse operation
+      if (!fuser.IsDone()) {
+         throw std::runtime_error("Initial Boolean union operation failed.");
+      }
+
+      // Retrieve the initial fused shape. Faces the Boolean left alone are shared with the
+      // halves, so the heal works on a copy and cannot widen their tolerances.
+      if (fuser.Shape().IsNull()) {
+         throw std::runtime_error("Fused shape is null after the initial union operation.");
+      }
+      TopoDS_Shape fusedShape = BRepBuilderAPI_Copy(fuser.Shape(), Standard_True, Standard_False).Shape();
+
+      // Call the function to handle intersecting bounding curves
+      handler.HandleIntersectingBoundingCurves(fusedShape, tolerances.sewing, sewFaces, tolerances.fixPrecision);
+      return fusedShape;
+   }
+
+   // The halves only meet within the overlap at the mirror plane. The left part is split at
+   // a plane clear of that slab, the mirrored pieces are the split pieces mirrored, and only
+   // the two slabs go through the Boolean and the heal. The far bodies share nothing with
+   // the seam but the cut faces, so a glue fuse puts them back. Returns a valid single solid,
+   // or a null shape when the part is too short for this to pay or any step fails.
+   TopoDS_Shape SeamUnion(IGESHandler& handler, const TopoDS_Shape& leftShape, bool sewFaces,
+      const Handle(NCollection_IncAllocator)& arena, bool runParallel, const UnionTolerances& tolerances, const Message_ProgressRange& range) {
+      PROSMART_TRACE_SCOPE("UnionShapes/SeamLocal");
+      Message_ProgressScope progress(range, "SeamUnion", 3);
+      try {
+         auto [xmin, ymin, zmin, xmax, ymax, zmax] = GetBBoxComp(leftShape);
+         const double slab = 2 * kSeamOverlap; // Keeps each far body a full overlap away from the other half
+         if (xmax - xmin < 4 * slab) {
+            std::cout << "Part too short for a seam-local union; fusing the whole halves." << std::endl;
+            return TopoDS_Shape();
+         }
+
+         // Split the left part at the slab boundary
+         PROSMART_TRACE_SPAN(splitSpan, "UnionShapes/SeamLocal/Split");
+         const double cutX = xmax - slab;
+         const double size = gp_Pnt(xmin, ymin, zmin).Distance(gp_Pnt(xmax, ymax, zmax));
+         const gp_Pln cutPlane(gp_Pnt(cutX, (ymin + ymax) / 2.0, (zmin + zmax) / 2.0), gp_Dir(1, 0, 0));
+         TopTools_ListOfShape arguments, tools;
+         arguments.Append(leftShape);
+         tools.Append(BRepBuilderAPI_MakeFace(cutPlane, -size, size, -size, size).Face());
+         BRepAlgoAPI_Splitter splitter;
+         splitter.SetArguments(arguments);
+         splitter.SetTools(tools);
+         splitter.SetRunParallel(runParallel);
+         splitter.SetNonDestructive(Standard_True);
+         splitter.Build(progress.Next());
+         if (progress.UserBreak()) {
+            throw std::runtime_error("The union was cancelled.");
+         }
+         if (splitter.HasErrors()) {
+            std::cout << "Splitting at the seam failed; fusing the whole halves." << std::endl;
+            return TopoDS_Shape();
+         }
+
+         // Sort the pieces by the side of the cut they lie on
+         BRep_Builder builder;
+         TopoDS_Compound farLeft, nearLeft;
+         builder.MakeCompound(farLeft);
+         builder.MakeCompound(nearLeft);
+         int nFar = 0, nNear = 0;
+         for (TopExp_Explorer explorer(splitter.Shape(), TopAbs_SOLID); explorer.More(); explorer.Next()) {
+            auto [pxmin, pymin, pzmin, pxmax, pymax, pzmax] = GetBBoxComp(explorer.Current());
+            if ((pxmin + pxmax) / 2.0 < cutX) {
+               builder.Add(farLeft, explorer.Current());
+               ++nFar;
+            }
+            else {
+               builder.Add(nearLeft, explorer.Current());
+               ++nNear;
+            }
+         }
+         PROSMART_TRACE_STOP(splitSpan);
+         if (nFar == 0 || nNear == 0) {
+            std::cout << "The seam cut did not divide the part; fusing the whole halves." << std::endl;
+            return TopoDS_Shape();
+         }
+
+         const gp_Trsf mirror = MirrorTrsf(leftShape);
+         const TopoDS_Shape nearMirrored = BRepBuilderAPI_Transform(nearLeft, mirror, true).Shape();
+         const TopoDS_Shape farMirrored = BRepBuilderAPI_Transform(farLeft, mirror, true).Shape();
+         const TopoDS_Shape seam = FuseHalves(handler, nearLeft, nearMirrored, sewFaces, arena, runParallel, tolerances, progress.Next());
+
+         PROSMART_TRACE_SPAN(glueSpan, "UnionShapes/SeamLocal/Glue");
+         TopTools_ListOfShape farBodies, seamPieces;
+         farBodies.Append(farLeft);
+         farBodies.Append(farMirrored);
+         seamPieces.Append(seam);
+         BRepAlgoAPI_Fuse glue;
+         glue.SetArguments(farBodies);
+         glue.SetTools(seamPieces);
+         glue.SetGlue(BOPAlgo_GlueShift);
+         glue.SetRunParallel(runParallel);
+         glue.SetNonDestructive(Standard_True);
+         glue.Build(progress.Next());
+         if (progress.UserBreak()) {
+            throw std::runtime_error("The union was cancelled.");
+         }
+         if (glue.HasErrors()) {
+            std::cout << "Gluing the far bodies to the seam failed; fusing the whole halves." << std::endl;
+            return TopoDS_Shape();
+         }
+
+         // Merge the faces split by the cut planes back together, and nothing else: every edge
+         // and vertex off the two cut planes is kept, so the rest of the part keeps its faces
+         const double mirroredCutX = gp_Pnt(cutX, 0, 0).Transformed(mirror).X();
+         auto onCut = [&](const TopoDS_Shape& shape, double tolerance) {
+            auto [sxmin, symin, szmin, sxmax, symax, szmax] = GetBBoxComp(shape);
+            for (double x : { cutX, mirroredCutX }) {
+               if (sxmin >= x - tolerance && sxmax <= x + tolerance) return true;
+            }
+            return false;
+         };
+         const double cutTolerance = 1e-3 * slab;
+         TopTools_MapOfShape keep;
+         for (TopExp_Explorer explorer(glue.Shape(), TopAbs_EDGE); explorer.More(); explorer.Next()) {
+            const TopoDS_Edge& edge = TopoDS::Edge(explorer.Current());
+            if (!onCut(edge, cutTolerance + BRep_Tool::Tolerance(edge))) keep.Add(edge);
+         }
+         for (TopExp_Explorer explorer(glue.Shape(), TopAbs_VERTEX); explorer.More(); explorer.Next()) {
+            const TopoDS_Vertex& vertex = TopoDS::Vertex(explorer.Current());
+            if (!onCut(vertex, cutTolerance + BRep_Tool::Tolerance(vertex))) keep.Add(vertex);
+         }
+         ShapeUpgrade_UnifySameDomain unify(glue.Shape(), Standard_True, Standard_True, Standard_False);
+         unify.KeepShapes(keep);
+         unify.Build();
+         const TopoDS_Shape result = unify.Shape();
+         PROSMART_TRACE_STOP(glueSpan);
+
+         TopTools_IndexedMapOfShape solids;
+         TopExp::MapShapes(result, TopAbs_SOLID, solids);
+         if (solids.Extent() != 1 || !BRepCheck_Analyzer(result).IsValid()) {
+            std::cout << "Seam-local union did not give one valid solid; fusing the whole halves." << std::endl;
+            return TopoDS_Shape();
+         }
+         return result;
+      }
+      catch (...) {
+         if (progress.UserBreak()) throw;
+         std::cout << "Seam-local union failed; fusing the whole halves." << std::endl;
+         return TopoDS_Shape();
+      }
+   }
+
+   // Fuse, heal, merge and check with one set of tolerances. Failures end up in the attempt;
+   // only a cancellation is thrown.
+   UnionAttempt Unite(IGESHandler& handler, const TopoDS_Shape& leftShape, const TopoDS_Shape& mirroredShape, bool sewFaces,
+      UnionMode mode, const Handle(NCollection_IncAllocator)& arena, bool runParallel, const UnionTolerances& tolerances,
+      const Message_ProgressRange& range) {
+      auto start = std::chrono::steady_clock::now();
+      Message_ProgressScope progress(range, "Unite", 2);
+      UnionAttempt attempt;
+      attempt.tolerances = tolerances;
+      try {
+         TopoDS_Shape fusedShape;
+         if (mode == UnionMode::SeamLocal) {
+            fusedShape = SeamUnion(handler, leftShape, sewFaces, arena, runParallel, tolerances, progress.Next());
+         }
+         const bool seamChecked = !fusedShape.IsNull(); // SeamUnion returns only valid single solids
+         if (!seamChecked) {
+            fusedShape = FuseHalves(handler, leftShape, mirroredShape, sewFaces, arena, runParallel, tolerances, progress.Next());
+         }
+
+         // Check for multiple connected components
+         PROSMART_TRACE_SPAN(mergeSpan, "UnionShapes/MergeSolids");
+         TopTools_IndexedMapOfShape solids(1, arena);
+         TopExp::MapShapes(fusedShape, TopAbs_SOLID, solids);
+
+         // If there's more than one solid, merge them
+         if (solids.Extent() > 1) {
+            std::cout << "Multiple connected components detected. Performing iterative union." << std::endl;
+
+            // Start with the first solid
+            TopoDS_Shape unifiedSolid = solids(1);
+
+            // Iteratively fuse the remaining solids
+            for (int i = 2; i <= solids.Extent(); ++i) {
+               BRepAlgoAPI_Fuse iterativeFuser(unifiedSolid, solids(i));
+               iterativeFuser.Build();
+
+               if (!iterativeFuser.IsDone()) {
+                  throw std::runtime_error("Iterative union operation failed.");
+               }
+
+               unifiedSolid = iterativeFuser.Shape();
+            }
+
+            // Update the fused shape to the unified result
+            fusedShape = unifiedSolid;
+         }
+         PROSMART_TRACE_STOP(mergeSpan);
+
+         PROSMART_TRACE_SCOPE("UnionShapes/Validate");
+         attempt.fused = fusedShape;
+         attempt.valid = seamChecked || BRepCheck_Analyzer(fusedShape).IsValid();
+         attempt.multipleSolids = handler.HasMultipleConnectedComponents(fusedShape);
+         if (!attempt.valid) attempt.failure = "invalid result";
+         else if (attempt.multipleSolids) attempt.failure = "several solids";
+      }
+      catch (const std::exception& ex) {
+         if (progress.UserBreak()) throw;
+         attempt.failure = ex.what();
+      }
+      catch (const Standard_Failure& failure) {
+         if (progress.UserBreak()) throw;
+         attempt.failure = failure.GetMessageString() != nullptr && *failure.GetMessageString() != '\0' ? failure.GetMessageString() : "geometry kernel error";
+      }
+      attempt.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      return attempt;
+   }
+
+   // A solid whose shells have no free edges and which passes the shape check
+   static bool IsClosedSolid(const TopoDS_Shape& shape) {
+      if (shape.ShapeType() != TopAbs_SOLID) return false;
+      for (TopExp_Explorer explorer(shape, TopAbs_SHELL); explorer.More(); explorer.Next()) {
+         if (!BRep_Tool::IsClosed(explorer.Current())) return false;
+      }
+      return BRepCheck_Analyzer(shape).IsValid();
+   }
+
+   // Largest vertex, edge or face tolerance of a shape
+   static double MaxTolerance(const TopoDS_Shape& shape) {
+      double tolerance = Precision::Confusion();
+      for (TopExp_Explorer explorer(shape, TopAbs_VERTEX); explorer.More(); explorer.Next()) {
+         tolerance = std::max(tolerance, BRep_Tool::Tolerance(TopoDS::Vertex(explorer.Current())));
+      }
+      for (TopExp_Explorer explorer(shape, TopAbs_EDGE); explorer.More(); explorer.Next()) {
+         tolerance = std::max(tolerance, BRep_Tool::Tolerance(TopoDS::Edge(explorer.Current())));
+      }
+      for (TopExp_Explorer explorer(shape, TopAbs_FACE); explorer.More(); explorer.Next()) {
+         tolerance = std::max(tolerance, BRep_Tool::Tolerance(TopoDS::Face(explorer.Current())));
+      }
+      return tolerance;
+   }
+
+   // Fuzzy values growing tenfold from twice the part's own tolerance, at most four. The cap
+   // follows the part: a ten-thousandth of its size or a hundred times its tolerance, but never
+   // over a tenth of the seam overlap, so gaps close without merging real features. A value
+   // within twice the one tried before it is skipped, as it would fail the same way.
+   static std::vector<UnionTolerances> EscalatedTolerances(double measured, double size, const UnionTolerances& first) {
+      const double cap = std::min(0.1 * kSeamOverlap, std::max(1e-4 * size, 100 * measured));
+      const double margin = 2.0;
+      double last = first.fuzzy;
+      std::vector<UnionTolerances> candidates;
+      auto add = [&](double fuzzy) {
+         UnionTolerances tolerances;
+         tolerances.fuzzy = fuzzy;
+         tolerances.sewing = std::max(first.sewing, 2 * fuzzy);
+         tolerances.fixPrecision = std::max(first.fixPrecision, fuzzy);
+         candidates.push_back(tolerances);
+         last = fuzzy;
+      };
+      for (double fuzzy = std::max(2 * measured, 1e-5); fuzzy < cap && candidates.size() < 4; fuzzy *= 10) {
+         if (fuzzy > margin * last) add(fuzzy);
+      }
+      if (candidates.size() < 4 && cap > margin * last) add(cap);
+      return candidates;
+   }
+
+   // Race the escalated tolerances, each on its own copies of the halves so that no two threads
+   // read the same shapes. Copies of both halves are large, so only a few candidates run at
+   // once, smallest first. A success cancels every larger candidate and the smallest success
+   // wins, so the result does not depend on which thread finishes first. Every attempt that
+   // ran is appended to attempts.
+   std::optional<UnionAttempt> Escalate(IGESHandler& handler, const TopoDS_Shape& leftShape, const TopoDS_Shape& mirroredShape,
+      bool sewFaces, UnionMode mode, double measured, const UnionTolerances& first, const Message_ProgressScope& outer,
+      std::vector<UnionAttempt>& attempts) {
+      PROSMART_TRACE_SCOPE("UnionShapes/Escalate");
+      auto [xmin, ymin, zmin, xmax, ymax, zmax] = GetBBoxComp(leftShape);
+      const double size = gp_Pnt(xmin, ymin, zmin).Distance(gp_Pnt(xmax, ymax, zmax));
+      const std::vector<UnionTolerances> candidates = EscalatedTolerances(measured, size, first);
+      const std::size_t limit = std::min<std::size_t>(kMaxCandidates, std::max(1u, std::thread::hardware_concurrency()));
+      std::vector<Handle(UnionCancelFlag)> flags(candidates.size());
+      std::vector<std::future<UnionAttempt>> jobs(candidates.size());
+      auto launch = [&](std::size_t i) {
+         Handle(UnionCancelFlag) flag = new UnionCancelFlag();
+         flags[i] = flag;
+         jobs[i] = std::async(std::launch::async, [this, &handler, leftShape, mirroredShape, sewFaces, mode, tolerances = candidates[i], flag]() {
+            PROSMART_TRACE_SCOPE("UnionShapes/Candidate");
+            const TopoDS_Shape left = BRepBuilderAPI_Copy(leftShape).Shape();
+            const TopoDS_Shape mirrored = BRepBuilderAPI_Copy(mirroredShape).Shape();
+            Handle(NCollection_IncAllocator) arena = MakeArena();
+            // Only a few candidates run at once, so each Boolean still uses every thread
+            return Unite(handler, left, mirrored, sewFaces, mode, arena, true, tolerances, flag->Start());
+         });
+      };
+
+      std::vector<UnionAttempt> results(candidates.size());
+      std::size_t best = candidates.size(); // Smallest candidate that succeeded so far
+      std::size_t started = 0, running = 0;
+      for (;;) {
+         if (outer.UserBreak()) {
+            for (std::size_t i = 0; i < started; ++i) flags[i]->Cancel();
+         }
+         // Candidates above a success are never started
+         while (running < limit && started < best && !outer.UserBreak()) {
+            launch(started++);
+            ++running;
+         }
+         if (running == 0) break;
+         for (std::size_t i = 0; i < started; ++i) {
+            if (!jobs[i].valid() || jobs[i].wait_for(std::chrono::milliseconds(20)) != std::future_status::ready) continue;
+            --running;
+            try {
+               results[i] = jobs[i].get();
+            }
+            catch (...) {
+               results[i].tolerances = candidates[i];
+               results[i].failure = flags[i]->UserBreak() ? "cancelled" : "unexpected error";
+            }
+            if (results[i].failure.empty() && i < best) {
+               best = i;
+               for (std::size_t j = i + 1; j < started; ++j) flags[j]->Cancel();
+            }
+         }
+      }
+      if (outer.UserBreak()) {
+         throw std::runtime_error("The union was cancelled.");
+      }
+      attempts.insert(attempts.end(), results.begin(), results.begin() + started);
+      if (best == candidates.size()) return std::nullopt;
+      return results[best];
+   }
+
+   static std::string Describe(const std::vector<UnionAttempt>& attempts) {
+      std::ostringstream out;
+      for (const UnionAttempt& attempt : attempts) {
+         if (&attempt != &attempts.front()) out << "; ";
+         out << "fuzzy " << attempt.tolerances.fuzzy << ", sewing " << attempt.tolerances.sewing
+            << ", fix " << attempt.tolerances.fixPrecision << ": "
+            << (attempt.failure.empty() ? "one valid solid" : attempt.failure);
+      }
+      return out.str();
+   }
+
+   // Mirror, fuse, heal and check, leaving the slots alone so this can run in the background
+   UnionOutcome ComputeUnion(IGESHandler& handler, const TopoDS_Shape& leftShape, UnionMode mode,
+      const Handle(NCollection_IncAllocator)& arena, bool runParallel, const Message_ProgressRange& range) {
+      auto start = std::chrono::steady_clock::now();
+      Message_ProgressScope progress(range, "UnionShapes", 2);
+      UnionOutcome outcome;
+      outcome.mirrored = MirrorShape(leftShape, outcome.mirrorTrsf);
+      const TopoDS_Shape& mirroredShape = outcome.mirrored;
+
+      // Check if both shapes are solids
+      if (leftShape.ShapeType() != TopAbs_SOLID || mirroredShape.ShapeType() != TopAbs_SOLID) {
+         throw std::runtime_error("Union operation requires both shapes to be solids.");
+      }
+
+      // Closed, valid halves give a closed fuse result, which needs no sewing; the mirrored
+      // half is an image of the left one, so checking the left covers both
+      const bool sewFaces = !IsClosedSolid(leftShape);
+
+      // Mesh-level pre-flight, so parts that cannot give one solid fail in milliseconds
+      const InterferenceOptions interferenceOptions;
+      const InterferenceReport interference = IGESInterference::Check(leftShape, mirroredShape, interferenceOptions);
+      std::cout << "Interference: " << IGESInterference::Format(interference) << std::endl;
+      if (interference.kind == InterferenceKind::Apart) {
+         throw std::runtime_error("The parts are " + std::to_string(interference.minDistance) + " apart; their union would not be one solid.");
+      }
+
+      // The input report is integrated while the fuse runs; the mirrored one is its image.
+      // The report reads a copy, so it never shares the halves with the Boolean's threads
+      const TopoDS_Shape leftCopy = BRepBuilderAPI_Copy(leftShape, Standard_True, Standard_False).Shape();
+      auto leftReport = std::async(std::launch::async, [this, leftShape, leftCopy] { return GetMassProperties(leftShape, leftCopy); });
+
+      // Measured before anything runs on the halves; the mirrored half is an image of the left
+      // one, so one measurement covers both
+      const double measured = MaxTolerance(leftShape);
+
+      // The fixed tolerances first, with every thread; growing ones only if they fail
+      UnionTolerances defaults;
+      defaults.fuzzy = interference.kind == InterferenceKind::Touching ? interferenceOptions.contactTolerance : 0.0;
+      std::vector<UnionAttempt> attempts;
+      attempts.push_back(Unite(handler, leftShape, mirroredShape, sewFaces, mode, arena, runParallel, defaults, progress.Next()));
+      std::optional<UnionAttempt> winner;
+      if (attempts.front().failure.empty()) {
+         winner = attempts.front();
+      }
+      else {
+         std::cout << "Union with the default tolerances failed (" << attempts.front().failure << "); trying larger ones." << std::endl;
+         winner = Escalate(handler, leftShape, mirroredShape, sewFaces, mode, measured, defaults, progress, attempts);
+      }
+      outcome.tolerances = Describe(attempts);
+      std::cout << "Union tolerances: " << outcome.tolerances << std::endl;
+
+      // With no winner the first attempt's result is kept, so it can be inspected
+      const UnionAttempt& chosen = winner ? *winner : attempts.front();
+      if (chosen.fused.IsNull()) {
+         throw std::runtime_error("No tolerance gave a union. Tolerances tried: " + outcome.tolerances);
+      }
+      outcome.fused = chosen.fused;
+      outcome.valid = chosen.valid;
+      outcome.multipleSolids = chosen.multipleSolids;
+      outcome.leftReport = leftReport.get();
+      outcome.mirroredReport = TransformReport(outcome.leftReport, outcome.mirrorTrsf);
+      outcome.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      return outcome;
+   }
+
+   void SetUnionMode(UnionMode mode) { mUnionMode = mode; }
+   UnionMode GetUnionMode() const { return mUnionMode; }
+
+   void SetSpeculativeUnion(bool enable) {
+      mSpeculate = enable;
+      if (!enable) CancelSpeculation();
+   }
+   bool GetSpeculativeUnion() const { return mSpeculate; }
+
+   // Unite the aligned left part on a low-priority thread. The worker waits kSpeculationDelay
+   // first, so a burst of alignments unites only the last part, then copies the part so the
+   // Boolean does not touch the tolerances of the one the viewer is showing meanwhile.
+   void StartSpeculation(IGESHandler& handler) {
+      CancelSpeculation();
+      const std::shared_ptr<const ShapeSlot> left = FindSlot(IGESHandler::SlotId(0));
+      if (!mSpeculate || left == nullptr || left->shape.IsNull()) return;
+
+      SpeculativeUnion speculation;
+      speculation.generation = left->generation;
+      speculation.mode = mUnionMode;
+      speculation.cancel = new UnionCancelFlag();
+      std::promise<void> copied;
+      speculation.copied = copied.get_future().share();
+      const TopoDS_Shape shape = left->shape;
+      const UnionMode mode = mUnionMode;
+      Handle(UnionCancelFlag) cancel = speculation.cancel;
+      speculation.outcome = std::async(std::launch::async, [this, &handler, shape, mode, cancel, copied = std::move(copied)]() mutable {
+         PROSMART_TRACE_SCOPE("SpeculativeUnion");
+         LowPriorityScope lowPriority;
+         TopoDS_Shape copy;
+         try {
+            const auto start = std::chrono::steady_clock::now();
+            while (!cancel->UserBreak() && std::chrono::steady_clock::now() - start < kSpeculationDelay) {
+               std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            if (!cancel->UserBreak()) copy = BRepBuilderAPI_Copy(shape, Standard_True, Standard_False).Shape();
+         }
+         catch (...) {
+            copied.set_value();
+            throw;
+         }
+         copied.set_value();
+         if (copy.IsNull()) throw std::runtime_error("The union was cancelled.");
+         // An arena of its own; the handler's belongs to unions on the calling thread. The
+         // Boolean runs serially so it stays in the background.
+         Handle(NCollection_IncAllocator) arena = MakeArena();
+         return ComputeUnion(handler, copy, mode, arena, false, cancel->Start());
+      });
+      mSpeculation = std::move(speculation);
+   }
+
+   // Returns once the worker has stopped reading the left part, so the caller may change it
+   void CancelSpeculation() {
+      if (!mSpeculation) return;
+      mSpeculation->cancel->Cancel();
+      mSpeculation->copied.wait();
+      // A std::async future blocks in its destructor; park it until the union notices
+      mRetiredSpeculations.erase(std::remove_if(mRetiredSpeculations.begin(), mRetiredSpeculations.end(),
+         [](const std::future<UnionOutcome>& f) { return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }),
+         mRetiredSpeculations.end());
+      mRetiredSpeculations.push_back(std::move(mSpeculation->outcome));
+      mSpeculation.reset();
+   }
+
+   // The background union, when it has finished on the current left part; otherwise it is
+   // cancelled and the caller unites itself. Waiting for it would leave the user on a serial,
+   // low-priority Boolean. A speculation that failed has failed for this part and mode, so
+   // its error is thrown rather than the union being run again.
+   std::optional<UnionOutcome> TakeSpeculation() {
+      if (!mSpeculation) return std::nullopt;
+      if (mSpeculation->generation != GetGeneration(IGESHandler::SlotId(0)) || mSpeculation->mode != mUnionMode
+         || mSpeculation->outcome.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+         CancelSpeculation();
+         return std::nullopt;
+      }
+      std::future<UnionOutcome> outcome = std::move(mSpeculation->outcome);
+      mSpeculation.reset();
+      return outcome.get();
    }
 
    Bnd_Box GetBBox(const TopoDS_Shape& shape) {
@@ -293,6 +1373,496 @@ class IGESHandler_PIMPL {
       return bbox;
    }
 
+   bool HasInteractiveView() const {
+      return !mInteractiveView.IsNull();
+   }
+
+   Handle(V3d_View) GetInteractiveView() const {
+      if (mInteractiveView.IsNull()) {
+         throw std::runtime_error("Interactive view is not initialized. Call RenderView first.");
+      }
+      return mInteractiveView;
+   }
+
+   // Create the persistent offscreen view on first use and keep it at width x height
+   Handle(V3d_View) EnsureInteractiveView(int width, int height) {
+      if (mInteractiveView.IsNull()) {
+         Handle(Aspect_DisplayConnection) displayConnection = new Aspect_DisplayConnection();
+         Handle(OpenGl_GraphicDriver) graphicDriver = new OpenGl_GraphicDriver(displayConnection);
+         mInteractiveViewer = new V3d_Viewer(graphicDriver);
+         mInteractiveViewer->SetDefaultLights();
+         mInteractiveViewer->SetLightOn();
+         mInteractiveContext = new AIS_InteractiveContext(mInteractiveViewer);
+
+         mInteractiveWindow = new Aspect_NeutralWindow();
+         mInteractiveWindow->SetSize(width, height);
+         mInteractiveWindow->SetVirtual(true);
+         mInteractiveView = mInteractiveViewer->CreateView();
+         mInteractiveView->SetImmediateUpdate(Standard_False); // Frames are drawn only by CaptureFrame
+         mInteractiveView->SetWindow(mInteractiveWindow);
+         mInteractiveView->SetBackgroundColor(Quantity_Color(Quantity_NOC_WHITE));
+         mSceneValid = false;
+      }
+
+      Standard_Integer currentWidth = 0, currentHeight = 0;
+      mInteractiveWindow->Size(currentWidth, currentHeight);
+      if (currentWidth != width || currentHeight != height) {
+         mInteractiveWindow->SetSize(width, height);
+         mInteractiveView->MustBeResized();
+      }
+      return mInteractiveView;
+   }
+
+   void SetFlipTest(FlipTest test) { mFlipTest = test; }
+   FlipTest GetFlipTest() const { return mFlipTest; }
+
+   std::shared_ptr<const FaceBoxIndex> GetFaceBoxIndex(const std::string& id) {
+      const std::shared_ptr<ShapeSlot> slot = GetSlot(id);
+      if (!slot->faceBoxes) {
+         PROSMART_TRACE_SCOPE("BuildFaceBoxIndex");
+         auto index = std::make_shared<FaceBoxIndex>();
+         index->Build(slot->shape);
+         slot->faceBoxes = index;
+      }
+      return slot->faceBoxes;
+   }
+
+   // Cached by shape identity and orientation; safe to call from several threads
+   MassPropertiesReport GetMassProperties(const TopoDS_Shape& shape) {
+      return GetMassProperties(shape, shape);
+   }
+
+   // Integrates `integrated`, an equal copy of `shape`, and caches the report under `shape`;
+   // for shapes another thread is changing
+   MassPropertiesReport GetMassProperties(const TopoDS_Shape& shape, const TopoDS_Shape& integrated) {
+      if (shape.IsNull()) return MassPropertiesReport();
+      {
+         std::lock_guard<std::mutex> lock(mMassMutex);
+         if (const MassPropertiesReport* cached = mMassCache.Seek(shape)) {
+            MassPropertiesReport report = *cached;
+            report.seconds = 0;
+            return report;
+         }
+      }
+      MassPropertiesReport report = IGESMassProperties::Compute(integrated);
+      std::lock_guard<std::mutex> lock(mMassMutex);
+      if (mMassCache.Extent() >= kMassCacheSize) mMassCache.Clear(); // Old parts are rarely asked for again
+      mMassCache.Bind(shape, report);
+      return report;
+   }
+
+   // Everything but the center is unchanged by a rigid or mirror transform
+   static MassPropertiesReport TransformReport(MassPropertiesReport report, const gp_Trsf& trsf) {
+      const gp_Pnt center = gp_Pnt(report.centerX, report.centerY, report.centerZ).Transformed(trsf);
+      report.centerX = center.X();
+      report.centerY = center.Y();
+      report.centerZ = center.Z();
+      report.seconds = 0;
+      return report;
+   }
+
+   MassPropertiesReport GetSlotMassProperties(const std::string& id) {
+      const std::shared_ptr<const ShapeSlot> slot = FindSlot(id);
+      if (slot == nullptr) return MassPropertiesReport();
+      if (SymmetrySource(*slot) != nullptr) {
+         return TransformReport(GetSlotMassProperties(slot->symmetry->source), slot->symmetry->trsf);
+      }
+      return GetMassProperties(slot->shape);
+   }
+
+   // Area vector of triangle i of a face's mesh, turned to face like the face
+   static gp_XYZ TriangleNormal(const TopoDS_Face& face, const Handle(Poly_Triangulation)& mesh, const TopLoc_Location& location, int i) {
+      int n1, n2, n3;
+      mesh->Triangle(i).Get(n1, n2, n3);
+      if (face.Orientation() == TopAbs_REVERSED) std::swap(n2, n3);
+      const gp_Trsf& trsf = location.Transformation();
+      const gp_XYZ p1 = mesh->Node(n1).Transformed(trsf).XYZ();
+      return (mesh->Node(n2).Transformed(trsf).XYZ() - p1).Crossed(mesh->Node(n3).Transformed(trsf).XYZ() - p1);
+   }
+
+   // Copy a meshed shape through trsf with its triangulation. A mirror turns the copied
+   // triangles inside out relative to their face, so each copied face whose triangles no
+   // longer face like the transformed source triangles has them reversed.
+   static TopoDS_Shape TransformMesh(const TopoDS_Shape& shape, const gp_Trsf& trsf) {
+      BRepBuilderAPI_Transform transform(shape, trsf, Standard_True, Standard_True);
+      if (!trsf.IsNegative()) return transform.Shape();
+      TopTools_IndexedMapOfShape faces;
+      TopExp::MapShapes(shape, TopAbs_FACE, faces);
+      for (int i = 1; i <= faces.Extent(); ++i) {
+         const TopoDS_Face& face = TopoDS::Face(faces(i));
+         const TopoDS_Face copy = TopoDS::Face(transform.ModifiedShape(face));
+         TopLoc_Location location, copyLocation;
+         Handle(Poly_Triangulation) source = BRep_Tool::Triangulation(face, location);
+         Handle(Poly_Triangulation) mesh = BRep_Tool::Triangulation(copy, copyLocation);
+         if (source.IsNull() || mesh.IsNull() || mesh->NbTriangles() != source->NbTriangles()) continue;
+         // The largest triangle decides for the face; small ones may be degenerate
+         int largest = 0;
+         gp_XYZ before;
+         for (int j = 1; j <= source->NbTriangles(); ++j) {
+            const gp_XYZ normal = TriangleNormal(face, source, location, j);
+            if (largest == 0 || normal.SquareModulus() > before.SquareModulus()) {
+               largest = j;
+               before = normal;
+            }
+         }
+         if (largest == 0) continue;
+         const gp_XYZ after = TriangleNormal(copy, mesh, copyLocation, largest);
+         if (after.Dot(gp_Vec(before).Transformed(trsf).XYZ()) >= 0) continue;
+         if (mesh == source) {
+            // Never reverse the source level's triangles
+            mesh = mesh->Copy();
+            BRep_Builder().UpdateFace(copy, mesh);
+         }
+         for (int j = 1; j <= mesh->NbTriangles(); ++j) {
+            int n1, n2, n3;
+            mesh->Triangle(j).Get(n1, n2, n3);
+            mesh->SetTriangle(j, Poly_Triangle(n1, n3, n2));
+         }
+      }
+      return transform.Shape();
+   }
+
+   // Start meshing a slot's levels of detail if its shape changed since they were made.
+   // Each level meshes its own copy, so the levels never share triangulations. An image of
+   // another slot transforms that slot's meshes instead.
+   void EnsureLods(const std::string& id) {
+      const std::shared_ptr<ShapeSlot> slot = GetSlot(id);
+      const TopoDS_Shape& shape = slot->shape;
+      const std::shared_ptr<const ShapeSlot> source = SymmetrySource(*slot);
+      if (source != nullptr) EnsureLods(slot->symmetry->source);
+      std::lock_guard<std::mutex> lock(mLodMutex);
+      ShapeLods& lods = slot->lods;
+      if (lods.generation == slot->generation && (shape.IsNull() || !lods.levels.empty())) return;
+
+      // A std::async future blocks in its destructor; park outdated jobs until they finish
+      mRetiredLods.erase(std::remove_if(mRetiredLods.begin(), mRetiredLods.end(), [](const std::shared_future<TopoDS_Shape>& job) {
+         return job.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+      }), mRetiredLods.end());
+      mRetiredLods.insert(mRetiredLods.end(), lods.levels.begin(), lods.levels.end());
+      lods.levels.clear();
+      lods.generation = slot->generation;
+      if (shape.IsNull()) return;
+
+      if (source != nullptr) {
+         const gp_Trsf trsf = slot->symmetry->trsf;
+         for (const std::shared_future<TopoDS_Shape>& level : source->lods.levels) {
+            lods.levels.push_back(std::async(std::launch::async, [level, trsf]() {
+               PROSMART_TRACE_SCOPE("MirrorLod");
+               // Copies the triangulation along with the geometry, which is far cheaper than meshing
+               return TransformMesh(level.get(), trsf);
+            }).share());
+         }
+         return;
+      }
+
+      // Deflection relative to the part size; the coarse level is started first
+      static const double kDeflections[kLodCount] = { 4e-3, 1e-3, 2.5e-4 };
+      static const double kAngles[kLodCount] = { 0.6, 0.35, 0.2 };
+      auto [xmin, ymin, zmin, xmax, ymax, zmax] = GetBBoxComp(shape);
+      const double diagonal = gp_Pnt(xmin, ymin, zmin).Distance(gp_Pnt(xmax, ymax, zmax));
+      for (int level = 0; level < kLodCount; ++level) {
+         const double deflection = diagonal * kDeflections[level];
+         const double angle = kAngles[level];
+         lods.levels.push_back(std::async(std::launch::async, [shape, deflection, angle]() {
+            PROSMART_TRACE_SCOPE("MeshLod");
+            BRepBuilderAPI_Copy copier(shape, Standard_False, Standard_False);
+            TopoDS_Shape copy = copier.Shape();
+            BRepMesh_IncrementalMesh mesher(copy, deflection, Standard_False, angle, Standard_True);
+            return copy;
+         }).share());
+      }
+   }
+
+   // The finest level of a slot, waiting for it to be meshed
+   TopoDS_Shape GetFinestLod(const std::string& id) {
+      EnsureLods(id);
+      std::shared_future<TopoDS_Shape> finest;
+      {
+         std::lock_guard<std::mutex> lock(mLodMutex);
+         const std::shared_ptr<const ShapeSlot> slot = GetSlot(id);
+         const ShapeLods& lods = slot->lods;
+         if (lods.levels.empty()) return TopoDS_Shape();
+         finest = lods.levels.back();
+      }
+      return finest.get();
+   }
+
+   // Coarse level while interacting; otherwise the finest level already meshed.
+   // Only the coarse level is ever waited for.
+   TopoDS_Shape PickLod(const std::string& id, bool coarse, int& level) {
+      std::vector<std::shared_future<TopoDS_Shape>> levels;
+      {
+         std::lock_guard<std::mutex> lock(mLodMutex);
+         levels = GetSlot(id)->lods.levels;
+      }
+      level = -1;
+      if (levels.empty()) return TopoDS_Shape();
+      if (!coarse) {
+         for (int i = static_cast<int>(levels.size()) - 1; i > 0; --i) {
+            if (levels[i].wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+               level = i;
+               return levels[i].get();
+            }
+         }
+      }
+      level = 0;
+      return levels[0].get();
+   }
+
+   void SetInteracting(bool interacting) {
+      mInteracting = interacting;
+   }
+
+   // Block until the finest level of every displayed slot is meshed or the timeout expires
+   bool WaitForFinestLods(int timeoutMs) {
+      std::vector<std::shared_future<TopoDS_Shape>> finest;
+      {
+         std::lock_guard<std::mutex> lock(mLodMutex);
+         for (const std::string& id : mSceneSlots) {
+            const std::shared_ptr<const ShapeSlot> slot = FindSlot(id);
+            if (slot != nullptr && !slot->lods.levels.empty()) finest.push_back(slot->lods.levels.back());
+         }
+      }
+      auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+      for (const auto& job : finest) {
+         if (job.wait_until(deadline) != std::future_status::ready) return false;
+      }
+      return true;
+   }
+
+   // Start meshing the levels of the slots a RenderView of this scene shows
+   void PrepareLods(bool fused) {
+      for (const std::string& id : { IGESHandler::SlotId(fused ? 2 : 0), IGESHandler::SlotId(3) }) {
+         if (FindSlot(id) != nullptr) EnsureLods(id);
+         if (fused) break;
+      }
+   }
+
+   // Redisplay only when the shapes or their level of detail changed since the last frame;
+   // otherwise the presentations already uploaded to the GPU are reused and only the camera moves
+   void RefreshInteractiveScene(bool fused) {
+      // The input scene shows the left part with its mirrored copy, like DumpInputShapes
+      const std::string slots[2] = { IGESHandler::SlotId(fused ? 2 : 0), fused ? std::string() : IGESHandler::SlotId(3) };
+      TopoDS_Shape shapes[2];
+      std::uint64_t generations[2] = {};
+      int levels[2] = { -1, -1 };
+      for (int i = 0; i < 2; ++i) {
+         if (FindSlot(slots[i]) == nullptr) continue;
+         EnsureLods(slots[i]);
+         shapes[i] = PickLod(slots[i], mInteracting, levels[i]);
+         generations[i] = GetGeneration(slots[i]);
+      }
+
+      if (mSceneValid && mSceneFused == fused && std::equal(generations, generations + 2, mSceneGeneration)
+         && std::equal(levels, levels + 2, mSceneLevel)) {
+         return;
+      }
+      PROSMART_TRACE_SCOPE("RefreshInteractiveScene");
+      mInteractiveContext->RemoveAll(Standard_False);
+
+      bool displayed = false;
+      for (const TopoDS_Shape& shape : shapes) {
+         if (shape.IsNull()) continue;
+         Handle(AIS_Shape) presentation = new AIS_Shape(shape);
+         // Draw the level's own mesh instead of letting AIS re-tessellate the shape
+         presentation->Attributes()->SetAutoTriangulation(Standard_False);
+         mInteractiveContext->Display(presentation, AIS_Shaded, 0, Standard_False);
+         displayed = true;
+      }
+      if (!displayed) {
+         throw std::runtime_error("No shapes are loaded to display.");
+      }
+
+      // Refit only when the content changes; a shape update or a new level keeps the camera
+      if (!mSceneValid || mSceneFused != fused) mInteractiveView->FitAll(0.01, Standard_False);
+      mSceneValid = true;
+      mSceneFused = fused;
+      std::copy(generations, generations + 2, mSceneGeneration);
+      std::copy(levels, levels + 2, mSceneLevel);
+
+      // LOD copies keep the topology order of their source, so face and edge indices carry over
+      for (int i = 0; i < 2; ++i) {
+         mSceneShapes[i] = shapes[i];
+         mSceneSlots[i] = shapes[i].IsNull() ? std::string() : slots[i];
+         mPickIndex[i].reset();
+      }
+      // Removed with the rest of the scene
+      mHighlight.Nullify();
+      mHoverHighlight.Nullify();
+      mHoverSlot.clear();
+      mHoverFace = 0;
+   }
+
+   // Null when nothing is displayed in scene position i
+   const PickIndex* GetPickIndex(int i) {
+      if (mSceneShapes[i].IsNull()) return nullptr;
+      if (!mPickIndex[i]) {
+         auto cached = std::find_if(mPickCache.begin(), mPickCache.end(), [&](const std::shared_ptr<PickIndex>& index) {
+            return index->shape.IsSame(mSceneShapes[i]);
+         });
+         if (cached != mPickCache.end()) {
+            mPickIndex[i] = *cached;
+            mPickCache.erase(cached);
+         }
+         else {
+            PROSMART_TRACE_SCOPE("BuildPickBVH");
+            auto index = std::make_shared<PickIndex>();
+            index->shape = mSceneShapes[i];
+            index->bvh.Build(index->shape);
+            TopExp::MapShapes(index->shape, TopAbs_EDGE, index->edges);
+            mPickIndex[i] = index;
+         }
+         mPickCache.push_back(mPickIndex[i]);
+         if (mPickCache.size() > kPickCacheSize) mPickCache.erase(mPickCache.begin());
+      }
+      return mPickIndex[i].get();
+   }
+
+   // Cast the ray under a view pixel against the displayed meshes
+   PickResult Pick(int x, int y) {
+      Handle(V3d_View) view = GetInteractiveView();
+      RefreshInteractiveScene(mSceneFused);
+
+      Standard_Real px, py, pz, vx, vy, vz;
+      view->ConvertWithProj(x, y, px, py, pz, vx, vy, vz);
+      gp_XYZ direction(vx, vy, vz);
+      if (direction.Modulus() < gp::Resolution()) return PickResult();
+      direction.Normalize();
+
+      // Start the ray behind everything on screen, whatever the projection
+      gp_XYZ onPlane(px, py, pz);
+      double backOff = 0.0;
+      for (int i = 0; i < 2; ++i) {
+         const PickIndex* index = GetPickIndex(i);
+         if (index == nullptr || index->bvh.IsEmpty()) continue;
+         const MeshBVH::Node& root = index->bvh.Nodes().front();
+         const gp_XYZ center = (root.min + root.max) * 0.5;
+         backOff = std::max(backOff, (center - onPlane).Modulus() + (root.max - root.min).Modulus());
+      }
+      const gp_XYZ origin = onPlane - direction * backOff;
+
+      PickResult result;
+      MeshBVH::RayHit nearest;
+      int nearestScene = -1;
+      for (int i = 0; i < 2; ++i) {
+         if (!mPickIndex[i] || mPickIndex[i]->bvh.IsEmpty()) continue;
+         MeshBVH::RayHit hit;
+         if (mPickIndex[i]->bvh.Intersect(origin, direction, hit) && (nearestScene < 0 || hit.t < nearest.t)) {
+            nearest = hit;
+            nearestScene = i;
+         }
+      }
+      if (nearestScene < 0) return result;
+
+      const MeshBVH& bvh = mPickIndex[nearestScene]->bvh;
+      const gp_Pnt point(origin + direction * nearest.t);
+      result.hit = true;
+      result.slot = mSceneSlots[nearestScene];
+      result.order = IGESHandler::SlotOrder(result.slot);
+      result.faceIndex = bvh.Triangles()[nearest.triangle].face;
+      result.x = point.X();
+      result.y = point.Y();
+      result.z = point.Z();
+
+      // Report an edge when the hit lies within a few pixels of one of the face's boundary polylines
+      const double tolerance = view->Convert(4);
+      const TopoDS_Face& face = TopoDS::Face(bvh.Faces()(result.faceIndex));
+      TopLoc_Location location;
+      Handle(Poly_Triangulation) mesh = BRep_Tool::Triangulation(face, location);
+      double bestDistance = tolerance;
+      for (TopExp_Explorer explorer(face, TopAbs_EDGE); explorer.More() && !mesh.IsNull(); explorer.Next()) {
+         const TopoDS_Edge& edge = TopoDS::Edge(explorer.Current());
+         Handle(Poly_PolygonOnTriangulation) polygon = BRep_Tool::PolygonOnTriangulation(edge, mesh, location);
+         if (polygon.IsNull()) continue;
+         const TColStd_Array1OfInteger& nodes = polygon->Nodes();
+         for (int i = nodes.Lower(); i < nodes.Upper(); ++i) {
+            const gp_Pnt a = mesh->Node(nodes(i)).Transformed(location.Transformation());
+            const gp_Pnt b = mesh->Node(nodes(i + 1)).Transformed(location.Transformation());
+            const gp_XYZ segment = b.XYZ() - a.XYZ();
+            const double lengthSquared = segment.SquareModulus();
+            double s = lengthSquared > 0 ? (point.XYZ() - a.XYZ()).Dot(segment) / lengthSquared : 0.0;
+            s = std::clamp(s, 0.0, 1.0);
+            const double distance = point.Distance(gp_Pnt(a.XYZ() + segment * s));
+            if (distance < bestDistance) {
+               bestDistance = distance;
+               result.edgeIndex = mPickIndex[nearestScene]->edges.FindIndex(edge);
+            }
+         }
+      }
+      return result;
+   }
+
+   // Overlay one face of a displayed shape; faceIndex <= 0 clears the highlight
+   void HighlightFace(const std::string& id, int faceIndex) {
+      GetInteractiveView();
+      RefreshInteractiveScene(mSceneFused);
+      if (!mHighlight.IsNull()) {
+         mInteractiveContext->Remove(mHighlight, Standard_False);
+         mHighlight.Nullify();
+      }
+      if (faceIndex <= 0) return;
+      mHighlight = DisplayFace(id, faceIndex, Quantity_NOC_ORANGE);
+   }
+
+   // Overlay the face under a view pixel, replacing the previous one. False when it is the
+   // face already overlaid, so the caller can skip rendering a frame.
+   bool Hover(int x, int y) {
+      const PickResult pick = Pick(x, y);
+      const std::string slot = pick.hit ? pick.slot : std::string();
+      const int face = pick.hit ? pick.faceIndex : 0;
+      if (slot == mHoverSlot && face == mHoverFace) return false;
+      if (!mHoverHighlight.IsNull()) {
+         mInteractiveContext->Remove(mHoverHighlight, Standard_False);
+         mHoverHighlight.Nullify();
+      }
+      mHoverSlot = slot;
+      mHoverFace = face;
+      if (face > 0) mHoverHighlight = DisplayFace(slot, face, Quantity_NOC_CYAN1);
+      return true;
+   }
+
+   Handle(AIS_Shape) DisplayFace(const std::string& id, int faceIndex, Quantity_NameOfColor color) {
+      for (int i = 0; i < 2; ++i) {
+         if (mSceneSlots[i].empty() || mSceneSlots[i] != id) continue;
+         const MeshBVH& bvh = GetPickIndex(i)->bvh;
+         if (faceIndex > bvh.Faces().Extent()) {
+            throw std::runtime_error("Face index is out of range.");
+         }
+         Handle(AIS_Shape) overlay = new AIS_Shape(bvh.Faces()(faceIndex));
+         overlay->Attributes()->SetAutoTriangulation(Standard_False);
+         overlay->SetColor(Quantity_Color(color));
+         overlay->SetZLayer(Graphic3d_ZLayerId_Top); // Drawn over the coincident part surface
+         mInteractiveContext->Display(overlay, AIS_Shaded, -1, Standard_False);
+         return overlay;
+      }
+      throw std::runtime_error("The requested shape is not displayed.");
+   }
+
+   // Render the current camera into the reused pixmap; returns top-down BGRA rows
+   std::vector<unsigned char> CaptureFrame() {
+      Handle(V3d_View) view = GetInteractiveView();
+      RefreshInteractiveScene(mSceneFused);
+
+      PROSMART_TRACE_SCOPE("CaptureFrame");
+      Standard_Integer width = 0, height = 0;
+      mInteractiveWindow->Size(width, height);
+      if (mFrame.IsEmpty() || mFrame.SizeX() != Standard_Size(width) || mFrame.SizeY() != Standard_Size(height)) {
+         if (!mFrame.InitZero(Image_Format_BGRA, width, height)) {
+            throw std::runtime_error("Failed to allocate the frame buffer.");
+         }
+      }
+      if (!view->ToPixMap(mFrame, width, height, Graphic3d_BT_RGBA)) {
+         throw std::runtime_error("Failed to render the view to pixmap.");
+      }
+
+      const size_t rowBytes = static_cast<size_t>(width) * 4;
+      std::vector<unsigned char> frame(rowBytes * height);
+      for (Standard_Integer row = 0; row < height; ++row) {
+         std::memcpy(frame.data() + row * rowBytes, mFrame.Row(row), rowBytes);
+      }
+      return frame;
+   }
+
    // Assuming bbox is a class with a Get method as described
    auto GetBBoxComp(const TopoDS_Shape& shape)
       -> std::tuple<double, double, double, double, double, double> {
@@ -317,7 +1887,7 @@ class IGESHandler_PIMPL {
 
    double ShortestDistanceBetweenShapes(gp_Pnt& pointOnShape1, gp_Pnt& pointOnShape2) {
       // Create an instance of BRepExtrema_DistShapeShape
-      BRepExtrema_DistShapeShape distanceCalculator(mShapeLeft, mShapeRight);
+      BRepExtrema_DistShapeShape distanceCalculator(GetSlotShape(0), GetSlotShape(1));
 
       // Check if the computation was successful
       if (!distanceCalculator.IsDone()) {
@@ -451,116 +2021,526 @@ class IGESHandler_PIMPL {
    //   ShapeUpgrade_UnifySameDomain unify(sewnShape, Standard_True, Standard_True, Standard_False);
    //   unify.Build();
 
-   //   return unify.Shape();
-   //}
-   void SewFlexes(TopoDS_Shape& shape) {
+   //   return unify.Shape();
+   //}
+   void SewFlexes(TopoDS_Shape& shape) {
+      try {
+         // Process and stitch the surfaces of revolution
+         TopoDS_Shape resultShape = processRevolutions(shape);
+
+         // Save the result
+         //BRepTools::Write(resultShape, "stitchedRevolutions.brep");
+
+         std::cout << "Successfully processed and stitched surfaces of revolution." << std::endl;
+      }
+      catch (const std::exception& e) {
+         std::cerr << "Error: " << e.what() << std::endl;
+      }
+   }
+   // Main function to process a shape
+   //TopoDS_Shape processCurvedFaces(const TopoDS_Shape& inputShape, double tolerance = 1e-6) {
+   //   // Step 1: Extract curved faces
+   //   std::vector<TopoDS_Face> curvedFaces = extractCurvedFaces(inputShape);
+
+   //   // Step 2: Group connected curved faces into clusters
+   //   std::vector<std::vector<TopoDS_Face>> clusters = groupConnectedCurvedFaces(curvedFaces, tolerance);
+
+   //   // Step 3: Process each cluster (sew and unify)
+   //   TopoDS_Compound result;
+   //   BRep_Builder builder;
+   //   builder.MakeCompound(result);
+
+   //   for (const auto& cluster : clusters) {
+   //      TopoDS_Shape unifiedCluster = sewAndUnifyCluster(cluster, tolerance);
+   //      builder.Add(result, unifiedCluster);
+   //   }
+
+   //   return result;
+   //}
+
+};
+
+
+
+
+IGESHandler::IGESHandler()
+// Initialize mShapeLeft pointer to nullptr
+{
+   mpIGESHandlerPimpl = std::make_unique< IGESHandler_PIMPL>();
+}
+
+IGESHandler::~IGESHandler()
+{
+   //// Cleanup the mShapeLeft pointer
+   //if (mShapeLeft != nullptr)
+   //{
+   //    delete mShapeLeft;
+   //    mShapeLeft = nullptr;
+   //}
+   //if (mShapeRight != nullptr)
+   //{
+   //    delete mShapeRight;
+   //    mShapeRight = nullptr;
+   //}
+}
+
+// Loads address parts by number: 0 is the left part, anything else the right one
+void IGESHandler::LoadIGES(const std::string& filePath, int order)
+{
+   LoadIGESToSlot(SlotId(order == 0 ? 0 : 1), filePath);
+}
+
+void IGESHandler::LoadSTEP(const std::string& filePath, int order)
+{
+   LoadSTEPToSlot(SlotId(order == 0 ? 0 : 1), filePath);
+}
+
+void IGESHandler::LoadShape(const std::string& filePath, int order)
+{
+   LoadSlot(SlotId(order == 0 ? 0 : 1), filePath);
+}
+
+void IGESHandler::LoadIGESToSlot(const std::string& id, const std::string& filePath)
+{
+   PROSMART_TRACE_SCOPE("LoadIGES");
+   try {
+      // Cheap pre-pass over the mapped file: reject what the translator cannot read
+      // before the full parse
+      IGESScanReport scan;
+      {
+         PROSMART_TRACE_SCOPE("LoadIGES/Scan");
+         scan = IGESScanner::Scan(filePath);
+      }
+      if (!scan.supported) {
+         throw std::runtime_error("Unsupported IGES file " + filePath + ": " + scan.error);
+      }
+      std::cout << "IGES scan: " << scan.nEntities << " entities (" << scan.nSurfaceEntities << " independent surfaces, "
+         << scan.nUnknownEntities << " unknown), estimated model size "
+         << scan.estimatedModelBytes / (1024 * 1024) << " MB" << std::endl;
+
+      InitTranslators();
+      TopoDS_Shape shape;
+      {
+         std::lock_guard<std::mutex> lock(TranslatorMutex());
+         IGESControl_Reader reader;
+         {
+            PROSMART_TRACE_SCOPE("LoadIGES/ReadFile");
+            if (!reader.ReadFile(filePath.c_str())) {
+               throw std::runtime_error("Failed to read IGES file: " + filePath);
+            }
+         }
+         {
+            PROSMART_TRACE_SCOPE("LoadIGES/TransferRoots");
+            reader.TransferRoots();
+         }
+         shape = reader.OneShape();
+      }
+
+      mpIGESHandlerPimpl->SetLoadedShape(id, shape, ShapeFormat::IGES);
+
+
+   }
+   catch (const std::exception& ex) {
+      std::cerr << "Exception in LoadIGES: " << ex.what() << std::endl;
+      throw;
+   }
+}
+
+void IGESHandler::InitTranslators()
+{
+   // The controllers register static data on first use, which is not safe from two threads
+   static std::once_flag once;
+   std::call_once(once, [] {
+      IGESControl_Controller::Init();
+      STEPControl_Controller::Init();
+   });
+}
+
+ShapeFormat IGESHandler::DetectFormat(const std::string& filePath)
+{
+   std::string extension;
+   size_t dot = filePath.find_last_of('.');
+   if (dot != std::string::npos) {
+      extension = filePath.substr(dot + 1);
+      std::transform(extension.begin(), extension.end(), extension.begin(),
+         [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+   }
+   if (extension == "igs" || extension == "iges") return ShapeFormat::IGES;
+   if (extension == "stp" || extension == "step") return ShapeFormat::STEP;
+   if (extension == "brep" || extension == "rle") return ShapeFormat::BRep;
+   if (extension == "stl") return ShapeFormat::STL;
+
+   // Unknown extension: sniff the first record
+   std::ifstream file(filePath, std::ios::binary);
+   char header[80] = {};
+   file.read(header, sizeof(header));
+   std::string head(header, static_cast<size_t>(file.gcount()));
+   if (head.find("ISO-10303-21") != std::string::npos) return ShapeFormat::STEP;
+   if (head.size() > 72 && head[72] == 'S') return ShapeFormat::IGES;
+   return ShapeFormat::Unknown;
+}
+
+void IGESHandler::LoadSlot(const std::string& id, const std::string& filePath)
+{
+   ShapeFormat format = DetectFormat(filePath);
+   auto start = std::chrono::steady_clock::now();
+   switch (format) {
+   case ShapeFormat::IGES: LoadIGESToSlot(id, filePath); break;
+   case ShapeFormat::STEP: LoadSTEPToSlot(id, filePath); break;
+   default: throw std::runtime_error("Unrecognized CAD file format: " + filePath);
+   }
+   double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   mpIGESHandlerPimpl->RecordLoadTime(format, seconds);
+}
+
+void IGESHandler::LoadSTEPToSlot(const std::string& id, const std::string& filePath)
+{
+   PROSMART_TRACE_SCOPE("LoadSTEP");
+   try {
+      InitTranslators();
+      TopoDS_Shape shape;
+      {
+         std::lock_guard<std::mutex> lock(TranslatorMutex());
+         STEPControl_Reader reader;
+         {
+            PROSMART_TRACE_SCOPE("LoadSTEP/ReadFile");
+            if (reader.ReadFile(filePath.c_str()) != IFSelect_RetDone) {
+               throw std::runtime_error("Failed to read STEP file: " + filePath);
+            }
+         }
+         {
+            PROSMART_TRACE_SCOPE("LoadSTEP/TransferRoots");
+            reader.TransferRoots();
+         }
+         shape = reader.OneShape();
+      }
+      if (shape.IsNull()) {
+         throw std::runtime_error("No shapes could be translated from STEP file: " + filePath);
+      }
+
+      // STEP usually wraps a single body in a compound; the union works on the solid itself
+      TopTools_IndexedMapOfShape solids;
+      TopExp::MapShapes(shape, TopAbs_SOLID, solids);
+      if (shape.ShapeType() == TopAbs_COMPOUND && solids.Extent() == 1) {
+         shape = solids(1);
+      }
+
+      mpIGESHandlerPimpl->SetLoadedShape(id, shape, ShapeFormat::STEP);
+   }
+   catch (const std::exception& ex) {
+      std::cerr << "Exception in LoadSTEP: " << ex.what() << std::endl;
+      throw;
+   }
+}
+
+void IGESHandler::SaveShape(const std::string& filePath, int order)
+{
+   switch (DetectFormat(filePath)) {
+   case ShapeFormat::STEP: SaveSTEP(filePath, order); break;
+   case ShapeFormat::BRep:
+   case ShapeFormat::STL: {
+      ExportResult result = ExportAll(order, { { DetectFormat(filePath), filePath } }).front();
+      if (!result.succeeded) throw std::runtime_error(result.error);
+      break;
+   }
+   default: SaveIGES(filePath, order); break;
+   }
+}
+
+void IGESHandler::SaveSTEP(const std::string& filePath, int order)
+{
+   PROSMART_TRACE_SCOPE("SaveSTEP");
+   TopoDS_Shape shape = mpIGESHandlerPimpl->GetSlotShape(order);
+
+   if (shape.IsNull())
+   {
+      throw std::runtime_error("No shape is loaded to save.");
+   }
+   std::lock_guard<std::mutex> lock(TranslatorMutex());
+   STEPControl_Writer writer;
+   if (writer.Transfer(shape, STEPControl_AsIs) != IFSelect_RetDone)
+   {
+      throw std::runtime_error("Failed to translate shape to STEP: " + filePath);
+   }
+   if (writer.Write(filePath.c_str()) != IFSelect_RetDone)
+   {
+      throw std::runtime_error("Failed to write STEP file: " + filePath);
+   }
+}
+
+std::vector<unsigned char> IGESHandler::ExportToMemory(int order, ShapeFormat format)
+{
+   TopoDS_Shape shape = mpIGESHandlerPimpl->GetSlotShape(order);
+
+   if (shape.IsNull())
+   {
+      throw std::runtime_error("No shape is loaded to export.");
+   }
+   return WriteShapeToMemory(shape, format);
+}
+
+IGESExportJob IGESHandler::ExportToMemoryAsync(int order, ShapeFormat format)
+{
+   TopoDS_Shape shape = mpIGESHandlerPimpl->GetSlotShape(order);
+
+   if (shape.IsNull())
+   {
+      throw std::runtime_error("No shape is loaded to export.");
+   }
+   // Fail here rather than in the job
+   if (format != ShapeFormat::IGES && format != ShapeFormat::STEP && format != ShapeFormat::BRep)
+   {
+      throw std::runtime_error("Only IGES, STEP and BRep can be exported to memory.");
+   }
+   // The job holds its own reference to the shape, so later loads into the slot do not affect it
+   return IGESExportJob::Start([shape, format]() {
       try {
-         // Process and stitch the surfaces of revolution
-         TopoDS_Shape resultShape = processRevolutions(shape);
+         return WriteShapeToMemory(shape, format);
+      }
+      catch (const Standard_Failure& failure) {
+         // Kernel errors are not std::exception; the wrapper only knows how to convert those
+         throw std::runtime_error(std::string("Export failed: ") + failure.GetMessageString());
+      }
+   });
+}
 
-         // Save the result
-         //BRepTools::Write(resultShape, "stitchedRevolutions.brep");
+std::vector<ExportResult> IGESHandler::ExportAll(int order, const std::vector<ExportTarget>& targets, double linearDeflection)
+{
+   PROSMART_TRACE_SCOPE("ExportAll");
+   TopoDS_Shape shape = mpIGESHandlerPimpl->GetSlotShape(order);
 
-         std::cout << "Successfully processed and stitched surfaces of revolution." << std::endl;
+   if (shape.IsNull())
+   {
+      throw std::runtime_error("No shape is loaded to export.");
+   }
+
+   // Reject what cannot be written before any work starts
+   for (const ExportTarget& target : targets) {
+      if (target.filePath.empty()) {
+         throw std::runtime_error("An export target has no file path.");
       }
-      catch (const std::exception& e) {
-         std::cerr << "Error: " << e.what() << std::endl;
+      switch (target.format) {
+      case ShapeFormat::IGES:
+      case ShapeFormat::STEP:
+      case ShapeFormat::BRep:
+      case ShapeFormat::STL:
+         break;
+      default:
+         throw std::runtime_error("Unsupported export format for " + target.filePath);
       }
    }
-   // Main function to process a shape
-   //TopoDS_Shape processCurvedFaces(const TopoDS_Shape& inputShape, double tolerance = 1e-6) {
-   //   // Step 1: Extract curved faces
-   //   std::vector<TopoDS_Face> curvedFaces = extractCurvedFaces(inputShape);
 
-   //   // Step 2: Group connected curved faces into clusters
-   //   std::vector<std::vector<TopoDS_Face>> clusters = groupConnectedCurvedFaces(curvedFaces, tolerance);
+   // Validate once for all writers
+   {
+      PROSMART_TRACE_SCOPE("ExportAll/Validate");
+      BRepCheck_Analyzer analyzer(shape);
+      if (!analyzer.IsValid()) {
+         throw std::runtime_error("The shape to export is invalid.");
+      }
+   }
 
-   //   // Step 3: Process each cluster (sew and unify)
-   //   TopoDS_Compound result;
-   //   BRep_Builder builder;
-   //   builder.MakeCompound(result);
+   // Triangulate a copy once; the STL writer and the BRep archive both use its stored mesh,
+   // while the slot's shape keeps the triangulation the viewer and the LODs share
+   bool needsMesh = std::any_of(targets.begin(), targets.end(), [](const ExportTarget& target) {
+      return target.format == ShapeFormat::STL || target.format == ShapeFormat::BRep;
+   });
+   TopoDS_Shape meshed = shape;
+   if (needsMesh) {
+      PROSMART_TRACE_SCOPE("ExportAll/Mesh");
+      meshed = BRepBuilderAPI_Copy(shape, Standard_True, Standard_False).Shape();
+      BRepMesh_IncrementalMesh mesher(meshed, linearDeflection, Standard_False, 0.5, Standard_True);
+      if (!mesher.IsDone()) {
+         throw std::runtime_error("Failed to triangulate the shape for export.");
+      }
+   }
 
-   //   for (const auto& cluster : clusters) {
-   //      TopoDS_Shape unifiedCluster = sewAndUnifyCluster(cluster, tolerance);
-   //      builder.Add(result, unifiedCluster);
-   //   }
+   // Before the writers race
+   InitTranslators();
+
+   // The writers only read the shape, so they run at once; the IGES and STEP ones take turns
+   // on the translator tables
+   std::vector<std::future<ExportResult>> pending;
+   for (const ExportTarget& target : targets) {
+      pending.push_back(std::async(std::launch::async, [shape, meshed, target]() {
+         PROSMART_TRACE_SCOPE("ExportAll/Write");
+         ExportResult result;
+         result.format = target.format;
+         result.filePath = target.filePath;
+         auto start = std::chrono::steady_clock::now();
+         try {
+            switch (target.format) {
+            case ShapeFormat::IGES: {
+               std::lock_guard<std::mutex> lock(TranslatorMutex());
+               IGESControl_Writer writer;
+               writer.AddShape(shape);
+               if (!writer.Write(target.filePath.c_str())) throw std::runtime_error("Failed to write IGES file: " + target.filePath);
+               break;
+            }
+            case ShapeFormat::STEP: {
+               std::lock_guard<std::mutex> lock(TranslatorMutex());
+               STEPControl_Writer writer;
+               if (writer.Transfer(shape, STEPControl_AsIs) != IFSelect_RetDone || writer.Write(target.filePath.c_str()) != IFSelect_RetDone)
+                  throw std::runtime_error("Failed to write STEP file: " + target.filePath);
+               break;
+            }
+            case ShapeFormat::BRep:
+               if (!BRepTools::Write(meshed, target.filePath.c_str())) throw std::runtime_error("Failed to write BRep file: " + target.filePath);
+               break;
+            case ShapeFormat::STL: {
+               StlAPI_Writer writer;
+               if (!writer.Write(meshed, target.filePath.c_str())) throw std::runtime_error("Failed to write STL file: " + target.filePath);
+               break;
+            }
+            default:
+               throw std::runtime_error("Unsupported export format for " + target.filePath);
+            }
+            result.succeeded = true;
+         }
+         catch (const Standard_Failure& failure) {
+            result.error = failure.GetMessageString();
+         }
+         catch (const std::exception& ex) {
+            result.error = ex.what();
+         }
+         result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+         return result;
+      }));
+   }
 
-   //   return result;
-   //}
+   std::vector<ExportResult> results;
+   for (auto& future : pending) {
+      results.push_back(future.get());
+      const ExportResult& result = results.back();
+      if (result.succeeded) std::cout << "Exported " << result.filePath << " in " << result.seconds << " s" << std::endl;
+      else std::cerr << "Export of " << result.filePath << " failed: " << result.error << std::endl;
+   }
+   return results;
+}
 
-};
+std::vector<FormatTimings> IGESHandler::GetFormatTimings() const
+{
+   return mpIGESHandlerPimpl->GetFormatTimings();
+}
 
+SliceReport IGESHandler::Slice(int order, const SliceOptions& options)
+{
+   const TopoDS_Shape& shape = mpIGESHandlerPimpl->GetSlotShape(order);
+   if (shape.IsNull()) {
+      throw std::runtime_error("Shape is not loaded.");
+   }
+   SliceReport report = IGESSlicer::Slice(shape, options, mpIGESHandlerPimpl->GetFaceBoxIndex(SlotId(order)).get());
+   for (const SliceResult& slice : report.slices) {
+      if (!slice.error.empty()) std::cerr << "Section at " << slice.station << " failed: " << slice.error << std::endl;
+   }
+   return report;
+}
 
+InterferenceReport IGESHandler::CheckInterference(int orderA, int orderB)
+{
+   PROSMART_TRACE_SCOPE("CheckInterference");
+   const TopoDS_Shape& a = mpIGESHandlerPimpl->GetSlotShape(orderA);
+   const TopoDS_Shape& b = mpIGESHandlerPimpl->GetSlotShape(orderB);
+   if (a.IsNull() || b.IsNull()) {
+      throw std::runtime_error("Both shapes must be loaded to check interference.");
+   }
+   return IGESInterference::Check(a, b);
+}
 
+MassPropertiesReport IGESHandler::GetMassProperties(int order)
+{
+   PROSMART_TRACE_SCOPE("GetMassProperties");
+   return mpIGESHandlerPimpl->GetSlotMassProperties(SlotId(order));
+}
 
-IGESHandler::IGESHandler()
-// Initialize mShapeLeft pointer to nullptr
+std::string IGESHandler::SlotId(int order)
 {
-   mpIGESHandlerPimpl = std::make_unique< IGESHandler_PIMPL>();
+   switch (order) {
+   case 0: return "left";
+   case 1: return "right";
+   case 2: return "fused";
+   case 3: return "mirrored";
+   default: throw std::runtime_error("Invalid shape order.");
+   }
 }
 
-IGESHandler::~IGESHandler()
+int IGESHandler::SlotOrder(const std::string& id)
 {
-   //// Cleanup the mShapeLeft pointer
-   //if (mShapeLeft != nullptr)
-   //{
-   //    delete mShapeLeft;
-   //    mShapeLeft = nullptr;
-   //}
-   //if (mShapeRight != nullptr)
-   //{
-   //    delete mShapeRight;
-   //    mShapeRight = nullptr;
-   //}
+   for (int order = 0; order < 4; ++order) {
+      if (SlotId(order) == id) return order;
+   }
+   return -1;
 }
 
-void IGESHandler::LoadIGES(const std::string& filePath, int order)
+std::vector<std::string> IGESHandler::GetSlotIds() const
 {
-   try {
-      IGESControl_Reader reader;
-      if (!reader.ReadFile(filePath.c_str())) {
-         throw std::runtime_error("Failed to read IGES file: " + filePath);
-      }
-      reader.TransferRoots();
+   return mpIGESHandlerPimpl->GetSlotIds();
+}
 
-      if (order == 0) {
-         /*if (mShapeLeft != nullptr) {
-             delete mShapeLeft;
-         }*/
-         //mShapeLeft = new TopoDS_Shape(reader.OneShape());
-         mpIGESHandlerPimpl->SetLeftShape(TopoDS_Shape(reader.OneShape()));
-         //return mShapeLeft;
-      }
-      else {
-         /*if (mShapeRight != nullptr) {
-             delete mShapeRight;
-         }*/
-         //mShapeRight = new TopoDS_Shape(reader.OneShape());
-         //return mShapeRight;
-         mpIGESHandlerPimpl->SetRightShape(TopoDS_Shape(reader.OneShape()));
-      }
+ShapeSlotInfo IGESHandler::GetSlotInfo(const std::string& id)
+{
+   ShapeSlotInfo info;
+   info.id = id;
+   info.loaded = !mpIGESHandlerPimpl->GetSlotShape(id).IsNull();
+   info.format = mpIGESHandlerPimpl->GetSourceFormat(id);
+   info.generation = mpIGESHandlerPimpl->GetGeneration(id);
+   if (!info.loaded) return info;
+
+   info.valid = mpIGESHandlerPimpl->IsSlotValid(id);
+   const Bnd_Box& box = mpIGESHandlerPimpl->GetSlotBox(id);
+   if (!box.IsVoid()) box.Get(info.bounds[0], info.bounds[1], info.bounds[2], info.bounds[3], info.bounds[4], info.bounds[5]);
+   return info;
+}
 
+void IGESHandler::RemoveSlot(const std::string& id)
+{
+   mpIGESHandlerPimpl->RemoveSlot(id);
+}
 
+void IGESHandler::UnionSlots(const std::vector<std::string>& ids, const std::string& resultId)
+{
+   PROSMART_TRACE_SCOPE("UnionSlots");
+   if (ids.size() < 2) {
+      throw std::runtime_error("A union needs at least two slots.");
    }
-   catch (const std::exception& ex) {
-      std::cerr << "Exception in LoadIGES: " << ex.what() << std::endl;
-      throw;
-   }
+
+   TopTools_ListOfShape arguments, tools;
+   for (const std::string& id : ids) {
+      const TopoDS_Shape& shape = mpIGESHandlerPimpl->GetSlotShape(id);
+      if (shape.IsNull()) {
+         throw std::runtime_error("Slot " + id + " has no shape to unite.");
+      }
+      // Validity is cached per slot, so a part taking part in several unions is checked once
+      if (!mpIGESHandlerPimpl->IsSlotValid(id)) {
+         throw std::runtime_error("The shape in slot " + id + " is invalid.");
+      }
+      (arguments.IsEmpty() ? arguments : tools).Append(shape);
+   }
+
+   BRepAlgoAPI_Fuse fuser;
+   fuser.SetArguments(arguments);
+   fuser.SetTools(tools);
+   fuser.SetRunParallel(Standard_True);
+   fuser.Build();
+   if (!fuser.IsDone() || fuser.Shape().IsNull()) {
+      throw std::runtime_error("Boolean union of the slots failed.");
+   }
+   // The fuse raises tolerances on the arguments in place, so their boxes and verdicts are stale
+   for (const std::string& id : ids) mpIGESHandlerPimpl->InvalidateSlotShape(id);
+   mpIGESHandlerPimpl->SetSlotShape(resultId, fuser.Shape());
+   std::cout << "Union of " << ids.size() << " slots stored in " << resultId << ": "
+      << IGESMassProperties::Format(mpIGESHandlerPimpl->GetMassProperties(fuser.Shape())) << std::endl;
 }
 
 void IGESHandler::SaveIGES(const std::string& filePath, int order)
 {
-   TopoDS_Shape shape;
-   if (order == 0)  shape = mpIGESHandlerPimpl->GetLeftShape();
-   else if (order == 1) shape = mpIGESHandlerPimpl->GetRightShape();
-   else if (order == 2) shape = mpIGESHandlerPimpl->GetFusedShape();
-
-
+   PROSMART_TRACE_SCOPE("SaveIGES");
+   TopoDS_Shape shape = mpIGESHandlerPimpl->GetSlotShape(order);
 
    if (shape.IsNull())
    {
       throw std::runtime_error("No mShapeLeft is loaded to save.");
    }
+   std::lock_guard<std::mutex> lock(TranslatorMutex());
    IGESControl_Writer writer;
    writer.AddShape(shape);
    if (!writer.Write(filePath.c_str()))
@@ -622,6 +2602,12 @@ void IGESHandler::ZoomIn()
       throw std::runtime_error("Viewer is not initialized.");
    }
 
+   // Prefer the persistent view the interactive frames come from
+   if (mpIGESHandlerPimpl->HasInteractiveView()) {
+      ZoomView(1.25);
+      return;
+   }
+
    if (mpIGESHandlerPimpl->GetViewer().IsNull()) {
       throw std::runtime_error("Viewer is not set in the viewer implementation.");
    }
@@ -653,6 +2639,11 @@ void IGESHandler::ZoomOut()
       throw std::runtime_error("Viewer is not initialized.");
    }
 
+   if (mpIGESHandlerPimpl->HasInteractiveView()) {
+      ZoomView(0.8);
+      return;
+   }
+
    if (mpIGESHandlerPimpl->GetViewer().IsNull()) {
       throw std::runtime_error("Viewer is not set in the viewer implementation.");
    }
@@ -678,6 +2669,91 @@ void IGESHandler::ZoomOut()
    view->Redraw();
 }
 
+std::vector<unsigned char> IGESHandler::RenderView(int width, int height, bool fused)
+{
+   PROSMART_TRACE_SCOPE("RenderView");
+   mpIGESHandlerPimpl->EnsureInteractiveView(width, height);
+   mpIGESHandlerPimpl->RefreshInteractiveScene(fused);
+   return mpIGESHandlerPimpl->CaptureFrame();
+}
+
+std::vector<unsigned char> IGESHandler::ZoomView(double factor)
+{
+   PROSMART_TRACE_SCOPE("ZoomView");
+   mpIGESHandlerPimpl->GetInteractiveView()->SetZoom(factor, Standard_True);
+   return mpIGESHandlerPimpl->CaptureFrame();
+}
+
+std::vector<unsigned char> IGESHandler::PanView(int dx, int dy)
+{
+   PROSMART_TRACE_SCOPE("PanView");
+   mpIGESHandlerPimpl->GetInteractiveView()->Pan(dx, dy);
+   return mpIGESHandlerPimpl->CaptureFrame();
+}
+
+std::vector<unsigned char> IGESHandler::OrbitView(double angleXDegrees, double angleYDegrees)
+{
+   PROSMART_TRACE_SCOPE("OrbitView");
+   // Rotate the eye about the screen axes through the view centre
+   mpIGESHandlerPimpl->GetInteractiveView()->Rotate(angleYDegrees * M_PI / 180.0, angleXDegrees * M_PI / 180.0, 0.0, Standard_True);
+   return mpIGESHandlerPimpl->CaptureFrame();
+}
+
+PickResult IGESHandler::Pick(int x, int y)
+{
+   PROSMART_TRACE_SCOPE("Pick");
+   return mpIGESHandlerPimpl->Pick(x, y);
+}
+
+std::vector<unsigned char> IGESHandler::HighlightFace(int order, int faceIndex)
+{
+   PROSMART_TRACE_SCOPE("HighlightFace");
+   mpIGESHandlerPimpl->HighlightFace(SlotId(order), faceIndex);
+   return mpIGESHandlerPimpl->CaptureFrame();
+}
+
+std::vector<unsigned char> IGESHandler::Hover(int x, int y)
+{
+   PROSMART_TRACE_SCOPE("Hover");
+   if (!mpIGESHandlerPimpl->Hover(x, y)) return {};
+   return mpIGESHandlerPimpl->CaptureFrame();
+}
+
+void IGESHandler::BeginInteraction()
+{
+   mpIGESHandlerPimpl->SetInteracting(true);
+}
+
+std::vector<unsigned char> IGESHandler::EndInteraction()
+{
+   PROSMART_TRACE_SCOPE("EndInteraction");
+   mpIGESHandlerPimpl->SetInteracting(false);
+   return mpIGESHandlerPimpl->CaptureFrame();
+}
+
+void IGESHandler::PrepareView(bool fused)
+{
+   PROSMART_TRACE_SCOPE("PrepareView");
+   mpIGESHandlerPimpl->PrepareLods(fused);
+}
+
+bool IGESHandler::WaitForDetail(int timeoutMs)
+{
+   return mpIGESHandlerPimpl->WaitForFinestLods(timeoutMs);
+}
+
+TopoDS_Shape IGESHandler::GetDetailedMesh(int order)
+{
+   return mpIGESHandlerPimpl->GetFinestLod(SlotId(order));
+}
+
+std::vector<unsigned char> IGESHandler::FitView()
+{
+   PROSMART_TRACE_SCOPE("FitView");
+   mpIGESHandlerPimpl->GetInteractiveView()->FitAll(0.01, Standard_False);
+   return mpIGESHandlerPimpl->CaptureFrame();
+}
+
 void  IGESHandler::RotatePartBy180AboutZAxis(int order) {
 
    TopoDS_Shape shape;
@@ -706,6 +2782,9 @@ void  IGESHandler::RotatePartBy180AboutZAxis(int order) {
    ScrewRotationAboutMidPart(shape, pt, parallelaxis, 180);
    if (order == 0) mpIGESHandlerPimpl->SetLeftShape(shape);
    else if (order == 1) mpIGESHandlerPimpl->SetRightShape(shape);
+   gp_Trsf rotationTrsf;
+   rotationTrsf.SetRotation(gp_Ax1(pt, parallelaxis), M_PI);
+   mpIGESHandlerPimpl->ApplyPlacement(order, rotationTrsf);
    AlignToXYPlane(order);
 }
 
@@ -756,8 +2835,9 @@ bool IGESHandler::IsPointOnAnySurface(const TopoDS_Shape& shape, const gp_Pnt& p
 }
 
 
-void IGESHandler::AlignToXYPlane(int order)
+void IGESHandler::AlignToXYPlane(int order, AlignmentMode mode)
 {
+   PROSMART_TRACE_SCOPE("AlignToXYPlane");
    TopoDS_Shape shape;
    if (order == 0) shape = mpIGESHandlerPimpl->GetLeftShape();
    else if (order == 1) shape = mpIGESHandlerPimpl->GetRightShape();
@@ -770,43 +2850,47 @@ void IGESHandler::AlignToXYPlane(int order)
          throw std::runtime_error("No mShapeRight is loaded to align.");
    }
 
-   // Compute the bounding box of the shape
-   /*Bnd_Box bbox;
-   BRepBndLib::Add(shape, bbox);
-   double xmin, ymin, zmin, xmax, ymax, zmax;
-   bbox.Get(xmin, ymin, zmin, xmax, ymax, zmax);*/
    double xmin, ymin, zmin, xmax, ymax, zmax;
-   std::tie(xmin, ymin, zmin, xmax, ymax, zmax) = mpIGESHandlerPimpl->GetBBoxComp(shape);
-
-   // Calculate dimensions
-   double length = xmax - xmin;
-   double width = ymax - ymin;
-   double height = zmax - zmin;
-
-   // Determine primary axes based on dimensions
-   gp_Dir xAxis(1, 0, 0);
-   gp_Dir yAxis(0, 1, 0);
-   gp_Dir zAxis(0, 0, 1);
-
-   if (length < width)
-      std::swap(length, width), std::swap(xAxis, yAxis);
-   if (length < height)
-      std::swap(length, height), std::swap(xAxis, zAxis);
-   if (width < height)
-      std::swap(width, height), std::swap(yAxis, zAxis);
-
-   // Align to the required orientation
-   gp_Ax3 targetSystem(gp_Pnt(0, 0, 0), zAxis, xAxis); // Z-axis up, X-axis along longest dimension
    gp_Trsf alignmentTrsf;
-   alignmentTrsf.SetTransformation(targetSystem, gp_Ax3(gp::Origin(), gp_Dir(0, 0, 1), gp_Dir(1, 0, 0)));
-   BRepBuilderAPI_Transform aligner(shape, alignmentTrsf, true);
+   if (mode == AlignmentMode::AxisAligned) {
+      // Compute the bounding box of the shape
+      /*Bnd_Box bbox;
+      BRepBndLib::Add(shape, bbox);
+      double xmin, ymin, zmin, xmax, ymax, zmax;
+      bbox.Get(xmin, ymin, zmin, xmax, ymax, zmax);*/
+      std::tie(xmin, ymin, zmin, xmax, ymax, zmax) = mpIGESHandlerPimpl->GetBBoxComp(shape);
+
+      // Calculate dimensions
+      double length = xmax - xmin;
+      double width = ymax - ymin;
+      double height = zmax - zmin;
+
+      // Determine primary axes based on dimensions
+      gp_Dir xAxis(1, 0, 0);
+      gp_Dir yAxis(0, 1, 0);
+      gp_Dir zAxis(0, 0, 1);
+
+      if (length < width)
+         std::swap(length, width), std::swap(xAxis, yAxis);
+      if (length < height)
+         std::swap(length, height), std::swap(xAxis, zAxis);
+      if (width < height)
+         std::swap(width, height), std::swap(yAxis, zAxis);
+
+      // Align to the required orientation
+      gp_Ax3 targetSystem(gp_Pnt(0, 0, 0), zAxis, xAxis); // Z-axis up, X-axis along longest dimension
+      alignmentTrsf.SetTransformation(targetSystem, gp_Ax3(gp::Origin(), gp_Dir(0, 0, 1), gp_Dir(1, 0, 0)));
+   }
+   else {
+      // Take the part's own frame to the world axes, whatever angle it was modelled at
+      alignmentTrsf.SetTransformation(IGESAlignment::PrincipalFrame(shape, mode));
+   }
 
-   // Recalculate the bounding box after alignment
-   TopoDS_Shape alignedShape = aligner.Shape();
+   // Bounding box in the aligned orientation, from a moved view of the shape rather than a copy
    /*bbox.SetVoid();
    BRepBndLib::Add(alignedShape, bbox);
    bbox.Get(xmin, ymin, zmin, xmax, ymax, zmax);*/
-   std::tie(xmin, ymin, zmin, xmax, ymax, zmax) = mpIGESHandlerPimpl->GetBBoxComp(alignedShape);
+   std::tie(xmin, ymin, zmin, xmax, ymax, zmax) = mpIGESHandlerPimpl->GetBBoxComp(shape.Moved(TopLoc_Location(alignmentTrsf)));
 
    // Calculate the translation required
    double yMid = (ymax + ymin) / 2.0;
@@ -816,12 +2900,11 @@ void IGESHandler::AlignToXYPlane(int order)
    gp_Trsf translationTrsf;
    translationTrsf.SetTranslation(translation);
 
-   // Apply the translation
-   BRepBuilderAPI_Transform finalTransform(alignedShape, translationTrsf, true);
-
-   // Testing the bounds
-   // Recalculate the bounding box after alignment
+   // Rotate and position in one copy; a stored mesh comes along for the ray-grid flip test
+   PROSMART_TRACE_SPAN(transformSpan, "AlignToXYPlane/Transform");
+   BRepBuilderAPI_Transform finalTransform(shape, translationTrsf * alignmentTrsf, true, true);
    shape = finalTransform.Shape();
+   PROSMART_TRACE_STOP(transformSpan);
 
 
    /*bbox.SetVoid();
@@ -835,10 +2918,25 @@ void IGESHandler::AlignToXYPlane(int order)
    gp_Pnt fromPt(xmid, ymid, zmid);
    gp_Dir fromPtDirNegZ(0, 0, -1);
    gp_Pnt ixnPt;
-   if (DoesVectorIntersectShape(shape, fromPt, fromPtDirNegZ, ixnPt)) {
+   gp_Trsf placementTrsf = translationTrsf * alignmentTrsf;
+   PROSMART_TRACE_SPAN(flipSpan, "AlignToXYPlane/FlipTest");
+   bool flip;
+   if (mpIGESHandlerPimpl->GetFlipTest() == FlipTest::RayGrid) {
+      const FlipVote vote = IGESAlignment::ClassifyFlip(shape);
+      // Too few decisive rays (flat or symmetric parts): fall back to the exact surface test
+      flip = vote.confidence >= 0.2 ? vote.flip : DoesVectorIntersectShape(shape, fromPt, fromPtDirNegZ, ixnPt);
+   }
+   else {
+      flip = DoesVectorIntersectShape(shape, fromPt, fromPtDirNegZ, ixnPt);
+   }
+   if (flip) {
       auto xAxis = gp_Dir(1, 0, 0);
       ScrewRotationAboutMidPart(shape, fromPt, xAxis, 180);
+      gp_Trsf flipTrsf;
+      flipTrsf.SetRotation(gp_Ax1(fromPt, xAxis), M_PI);
+      placementTrsf = flipTrsf * placementTrsf;
    }
+   PROSMART_TRACE_STOP(flipSpan);
 
    /*auto pt = gp_Pnt(xmin, ymid, zmin);
    if (IsPointOnAnySurface(shapePtr, pt, 1e-3)) {
@@ -858,6 +2956,10 @@ void IGESHandler::AlignToXYPlane(int order)
     //shape = TopoDS_Shape(finalTransform.Shape());
    if (order == 0) mpIGESHandlerPimpl->SetLeftShape(shape);
    else if (order == 1) mpIGESHandlerPimpl->SetRightShape(shape);
+   mpIGESHandlerPimpl->ApplyPlacement(order, placementTrsf);
+
+   // The operator usually unites next; get a head start on it
+   if (order == 0) mpIGESHandlerPimpl->StartSpeculation(*this);
    //*shapePtr = ptr;
 
    //// Align mShapeRight relative to mShapeLeft if both are present
@@ -1112,6 +3214,7 @@ bool IGESHandler::DoesVectorIntersectShape(const TopoDS_Shape& shape, const gp_P
 
 std::vector<unsigned char> IGESHandler::DumpInputShapes(const int width, const int height)
 {
+   PROSMART_TRACE_SCOPE("DumpInputShapes");
    try {
       std::vector<unsigned char> res;
       auto leftShape = mpIGESHandlerPimpl->GetLeftShape();
@@ -1122,6 +3225,7 @@ std::vector<unsigned char> IGESHandler::DumpInputShapes(const int width, const i
       }
 
       // Initialize viewer
+      PROSMART_TRACE_SPAN(setupSpan, "DumpInputShapes/ViewerSetup");
       Handle(Aspect_DisplayConnection) displayConnection = new Aspect_DisplayConnection();
       Handle(OpenGl_GraphicDriver) graphicDriver = new OpenGl_GraphicDriver(displayConnection);
       auto v3dViewer = (Handle(V3d_Viewer)(new V3d_Viewer(graphicDriver)));
@@ -1139,8 +3243,10 @@ std::vector<unsigned char> IGESHandler::DumpInputShapes(const int width, const i
       view->SetWindow(wnd);
       view->SetBackgroundColor(Quantity_Color(Quantity_NOC_WHITE));
       view->MustBeResized();
+      PROSMART_TRACE_STOP(setupSpan);
 
       // Calculate bounding box
+      PROSMART_TRACE_SPAN(displaySpan, "DumpInputShapes/Display");
       Bnd_Box combinedBoundingBox;
       if (!leftShape.IsNull()) {
          Handle(AIS_Shape) leftPresentation = new AIS_Shape(leftShape);
@@ -1171,12 +3277,15 @@ std::vector<unsigned char> IGESHandler::DumpInputShapes(const int width, const i
       view->SetAt(bboxCenter.X(), bboxCenter.Y(), bboxCenter.Z());
       view->SetZoom(1.5);
       view->Redraw();
+      PROSMART_TRACE_STOP(displaySpan);
 
       // Capture pixmap
+      PROSMART_TRACE_SPAN(pixmapSpan, "DumpInputShapes/ToPixMap");
       Image_AlienPixMap img;
       if (!view->ToPixMap(img, width, height)) {
          throw std::runtime_error("Failed to render the view to pixmap.");
       }
+      PROSMART_TRACE_STOP(pixmapSpan);
 
       TCollection_AsciiString filename = "C:\\temp\\input_shapes.png";
       img.Save(filename);
@@ -1200,6 +3309,7 @@ std::vector<unsigned char> IGESHandler::DumpInputShapes(const int width, const i
 
 std::vector<unsigned char> IGESHandler::DumpFusedShape(const int width, const int height)
 {
+   PROSMART_TRACE_SCOPE("DumpFusedShape");
    std::vector<unsigned char> res;
    auto fusedShape = mpIGESHandlerPimpl->GetFusedShape();
    //auto mirroredShape = mpIGESHandlerPimpl->GetMirroredShape();
@@ -1209,6 +3319,7 @@ std::vector<unsigned char> IGESHandler::DumpFusedShape(const int width, const in
 
 
    // Prepare viewer
+   PROSMART_TRACE_SPAN(setupSpan, "DumpFusedShape/ViewerSetup");
    Handle(Aspect_DisplayConnection) displayConnection = new Aspect_DisplayConnection();
    Handle(OpenGl_GraphicDriver) graphicDriver = new OpenGl_GraphicDriver(displayConnection);
 
@@ -1232,8 +3343,10 @@ std::vector<unsigned char> IGESHandler::DumpFusedShape(const int width, const in
    view->SetWindow(wnd);
    view->SetBackgroundColor(Quantity_Color(Quantity_NOC_WHITE));
    view->MustBeResized();
+   PROSMART_TRACE_STOP(setupSpan);
 
    // Prepare bounding box for fitting
+   PROSMART_TRACE_SPAN(displaySpan, "DumpFusedShape/Display");
    Bnd_Box combinedBoundingBox;
 
    // Display mShapeLeft if available
@@ -1252,8 +3365,10 @@ std::vector<unsigned char> IGESHandler::DumpFusedShape(const int width, const in
    // Fit view and redraw
    view->FitAll(0.01, Standard_True);
    view->Redraw();
+   PROSMART_TRACE_STOP(displaySpan);
 
    // Prepare pixmap image
+   PROSMART_TRACE_SPAN(pixmapSpan, "DumpFusedShape/ToPixMap");
    Image_AlienPixMap img;
    if (!view->ToPixMap(img, width, height)) {
       throw std::runtime_error("Failed to render the view to pixmap.");
@@ -1262,6 +3377,7 @@ std::vector<unsigned char> IGESHandler::DumpFusedShape(const int width, const in
    // Save image into a temporary file
    TCollection_AsciiString filename = "C:\\temp\\fused_shape.png";
    img.Save(filename);
+   PROSMART_TRACE_STOP(pixmapSpan);
 
    // Read the file content into memory
    std::ifstream file(filename.ToCString(), std::ios::binary);
@@ -1347,94 +3463,56 @@ void  IGESHandler::PerformZoomAndRender(bool zoomIn)
 //    }
 //}
 void IGESHandler::UnionShapes() {
+   PROSMART_TRACE_SCOPE("UnionShapes");
+   auto unionStart = std::chrono::steady_clock::now();
+   // Declared before the try block, so the arena is rewound after its users are destroyed
+   IGESHandler_PIMPL::ArenaScope arenaScope{ mpIGESHandlerPimpl->GetArena() };
    try {
-      // Retrieve the shapes from the handler
-      auto leftShape = mpIGESHandlerPimpl->GetLeftShape();
-      Mirror();
-      auto mirroredShape = mpIGESHandlerPimpl->GetMirroredShape();
-
-
-      // Ensure both shapes are valid
-      if (leftShape.IsNull()) {
-         throw std::runtime_error("Left shape is null or not loaded.");
-      }
-      if (mirroredShape.IsNull()) {
-         throw std::runtime_error("Right shape is null or not loaded.");
-      }
-
-      // Check if both shapes are solids
-      if (leftShape.ShapeType() != TopAbs_SOLID || mirroredShape.ShapeType() != TopAbs_SOLID) {
-         throw std::runtime_error("Union operation requires both shapes to be solids.");
-      }
-
-      // Perform the initial union operation
-      BRepAlgoAPI_Fuse fuser(leftShape, mirroredShape);
-      fuser.Build();
-
-      // Validate the fuse operation
-      if (!fuser.IsDone()) {
-         throw std::runtime_error("Initial Boolean union operation failed.");
+      // A part that has only moved rigidly since the last union gets that union, moved along
+      if (mpIGESHandlerPimpl->ReuseUnion()) {
+         mpIGESHandlerPimpl->CancelSpeculation(); // Its result is not needed
+         double reuseSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - unionStart).count();
+         std::cout << "Boolean union reused from the previous result in " << reuseSeconds * 1000.0 << " ms." << std::endl;
+         return;
       }
 
-      // Retrieve the initial fused shape
-      TopoDS_Shape fusedShape = fuser.Shape();
-      if (fusedShape.IsNull()) {
-         throw std::runtime_error("Fused shape is null after the initial union operation.");
+      // Adopt the union started in the background after the last alignment, or unite here
+      const ShapeFormat leftFormat = mpIGESHandlerPimpl->GetSourceFormat(0);
+      std::optional<UnionOutcome> outcome = mpIGESHandlerPimpl->TakeSpeculation();
+      if (outcome) {
+         double waitSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - unionStart).count();
+         std::cout << "Speculative union adopted in " << waitSeconds * 1000.0 << " ms." << std::endl;
       }
-
-      // Call the function to handle intersecting bounding curves
-      double tolerance = 1e-2; // Adjust the tolerance as needed
-      HandleIntersectingBoundingCurves(fusedShape, tolerance);
-
-      //fusedShape = mpIGESHandlerPimpl->processCurvedFaces(fusedShape, tolerance = 1e-3);
-      //mpIGESHandlerPimpl->SewFlexes(fusedShape);
-
-      // Check for multiple connected components
-      TopTools_IndexedMapOfShape solids;
-      TopExp::MapShapes(fusedShape, TopAbs_SOLID, solids);
-
-      // If there's more than one solid, merge them
-      if (solids.Extent() > 1) {
-         std::cout << "Multiple connected components detected. Performing iterative union." << std::endl;
-
-         // Start with the first solid
-         TopoDS_Shape unifiedSolid = solids(1);
-
-         // Iteratively fuse the remaining solids
-         for (int i = 2; i <= solids.Extent(); ++i) {
-            BRepAlgoAPI_Fuse iterativeFuser(unifiedSolid, solids(i));
-            iterativeFuser.Build();
-
-            if (!iterativeFuser.IsDone()) {
-               throw std::runtime_error("Iterative union operation failed.");
-            }
-
-            unifiedSolid = iterativeFuser.Shape();
-         }
-
-         // Update the fused shape to the unified result
-         fusedShape = unifiedSolid;
+      else {
+         outcome = mpIGESHandlerPimpl->ComputeUnion(*this, mpIGESHandlerPimpl->GetLeftShape(), mpIGESHandlerPimpl->GetUnionMode(),
+            mpIGESHandlerPimpl->GetArena(), true, Message_ProgressRange());
       }
 
-      // Store the final fused shape and fuser in the handler
-      mpIGESHandlerPimpl->SetFuser(fuser); // Optionally store the last fuser
-      mpIGESHandlerPimpl->SetFusedShape(fusedShape);
+      // Store the final fused shape in the handler; the fuser referred to the arena and went with it
+      mpIGESHandlerPimpl->SetMirroredImage(outcome->mirrored, outcome->mirrorTrsf);
+      mpIGESHandlerPimpl->SetFusedShape(outcome->fused);
 
       // Optional: Validate the final fused shape
-      BRepCheck_Analyzer analyzer(fusedShape);
-      if (!analyzer.IsValid()) {
-         throw std::runtime_error("Final fused shape is invalid.");
+      if (!outcome->valid) {
+         throw std::runtime_error("Final fused shape is invalid. Tolerances tried: " + outcome->tolerances);
       }
 
-      if (HasMultipleConnectedComponents(fusedShape)) {
-         throw std::runtime_error("Fused shape contains multiple connected components.");
+      if (outcome->multipleSolids) {
+         throw std::runtime_error("Fused shape contains multiple connected components. Tolerances tried: " + outcome->tolerances);
       }
+      mpIGESHandlerPimpl->GetSlot(SlotId(2))->valid = true;
+      mpIGESHandlerPimpl->CacheUnion();
+      mpIGESHandlerPimpl->RecordUnionTime(leftFormat, outcome->seconds);
       std::cout << "Boolean union operation completed successfully." << std::endl;
 
+      std::cout << "Left: " << IGESMassProperties::Format(outcome->leftReport) << std::endl;
+      std::cout << "Mirrored: " << IGESMassProperties::Format(outcome->mirroredReport) << std::endl;
+      std::cout << "Fused: " << IGESMassProperties::Format(mpIGESHandlerPimpl->GetMassProperties(outcome->fused)) << std::endl;
+
    }
    catch (const std::exception& ex) {
       std::cerr << "Error in UnionShapes: " << ex.what() << std::endl;
-      throw std::runtime_error("More than 1 connected components found in boolean union");
+      throw std::runtime_error(std::string("Boolean union failed: ") + ex.what());
    }
    catch (...) {
       std::cerr << "Unknown error occurred in UnionShapes." << std::endl;
@@ -1443,37 +3521,10 @@ void IGESHandler::UnionShapes() {
 }
 
 void IGESHandler::Mirror() {
-   // Retrieve the left shape
-   auto leftShape = mpIGESHandlerPimpl->GetLeftShape();
-
-   if (leftShape.IsNull()) {
-      throw std::runtime_error("Left shape is null or not loaded.");
-   }
-
-   // Compute the bounding box of the left shape
-   auto [xmin, ymin, zmin, xmax, ymax, zmax] = mpIGESHandlerPimpl->GetBBoxComp(leftShape);
-
-   // Define the mirror plane passing through (xmax, ymax, zmax) with normal (-1, 0, 0)
-   gp_Pnt planePoint(xmax, ymax, zmax);
-   gp_Dir planeNormal(-1, 0, 0);
-   gp_Ax2 mirrorPlane(planePoint, planeNormal);
-
-   // Create a transformation for mirroring
-   gp_Trsf mirrorTransformation;
-   mirrorTransformation.SetMirror(mirrorPlane);
-
-   // Apply the mirroring transformation to the left shape
-   BRepBuilderAPI_Transform mirroringTransform(leftShape, mirrorTransformation, true);
-   TopoDS_Shape mirroredShape = mirroringTransform.Shape();
-
-   if (mirroredShape.IsNull()) {
-      throw std::runtime_error("Failed to create mirrored shape.");
-   }
-
-   mirroredShape = mpIGESHandlerPimpl->TranslateAlongX(mirroredShape, -0.9);
-
    // Store the mirrored shape
-   mpIGESHandlerPimpl->SetMirroredShape(mirroredShape);
+   gp_Trsf mirrorTrsf;
+   const TopoDS_Shape mirroredShape = mpIGESHandlerPimpl->MirrorShape(mpIGESHandlerPimpl->GetLeftShape(), mirrorTrsf);
+   mpIGESHandlerPimpl->SetMirroredImage(mirroredShape, mirrorTrsf);
 
    std::cout << "Mirroring operation completed successfully." << std::endl;
 }
@@ -1560,7 +3611,7 @@ void IGESHandler::Mirror() {
 //   std::cout << "Intersecting bounding curves handled successfully with lazy evaluation." << std::endl;
 //}
 
-void IGESHandler::HandleIntersectingBoundingCurves(TopoDS_Shape& fusedShape, double tolerance) {
+void IGESHandler::HandleIntersectingBoundingCurves(TopoDS_Shape& fusedShape, double tolerance, bool sewFaces, double fixPrecision) {
 
    //// Create the ShapeUpgrade_UnifySameDomain object
    //ShapeUpgrade_UnifySameDomain unify(fusedShape, Standard_True, Standard_True, Standard_False);
@@ -1571,29 +3622,41 @@ void IGESHandler::HandleIntersectingBoundingCurves(TopoDS_Shape& fusedShape, dou
    //// Get the refined shape
    //fusedShape = unify.Shape();
 
- // Step 1: Sew gaps between surfaces
-   BRepBuilderAPI_Sewing sewing(tolerance);
-   sewing.Add(fusedShape);
-   sewing.Perform();
-   TopoDS_Shape sewedShape = sewing.SewedShape();
+   PROSMART_TRACE_SCOPE("HandleIntersectingBoundingCurves");
+   if (sewFaces) {
+      // Step 1: Sew gaps between surfaces
+      PROSMART_TRACE_SPAN(sewSpan, "HandleIntersectingBoundingCurves/Sew");
+      BRepBuilderAPI_Sewing sewing(tolerance);
+      sewing.Add(fusedShape);
+      sewing.Perform();
+      TopoDS_Shape sewedShape = sewing.SewedShape();
+      PROSMART_TRACE_STOP(sewSpan);
 
-   // Step 2: Fuse surfaces to create a single solid
-   BRepAlgoAPI_Fuse fuse(sewedShape, sewedShape); // Self-fuse
-   fuse.Build();
-   fusedShape = fuse.Shape();
+      // Step 2: Fuse surfaces to create a single solid
+      PROSMART_TRACE_SPAN(selfFuseSpan, "HandleIntersectingBoundingCurves/SelfFuse");
+      BRepAlgoAPI_Fuse fuse(sewedShape, sewedShape); // Self-fuse
+      fuse.Build();
+      fusedShape = fuse.Shape();
+      PROSMART_TRACE_STOP(selfFuseSpan);
+   }
 
    // Step 3: Refine the shape to remove small edges
+   PROSMART_TRACE_SPAN(unifySpan, "HandleIntersectingBoundingCurves/Unify");
    ShapeUpgrade_UnifySameDomain unify(fusedShape, Standard_True, Standard_True, Standard_False);
    unify.Build();
    fusedShape = unify.Shape();
+   PROSMART_TRACE_STOP(unifySpan);
 
    // Step 1: Heal the shape to fix gaps and ensure continuity
+   PROSMART_TRACE_SPAN(healSpan, "HandleIntersectingBoundingCurves/ShapeFix");
    Handle(ShapeFix_Shape) shapeFix = new ShapeFix_Shape(fusedShape);
-   shapeFix->SetPrecision(1e-3); // Set tolerance for fixing gaps
+   shapeFix->SetPrecision(fixPrecision); // Set tolerance for fixing gaps
    shapeFix->Perform(); // Perform the healing operation
    TopoDS_Shape healedShape = shapeFix->Shape();
+   PROSMART_TRACE_STOP(healSpan);
 
    // Step 2: Refine the healed shape
+   PROSMART_TRACE_SCOPE("HandleIntersectingBoundingCurves/RefineHealed");
    unify = ShapeUpgrade_UnifySameDomain(healedShape, Standard_True, Standard_True, Standard_False);
    unify.Build();
 
@@ -1663,7 +3726,193 @@ resultBuilder.MakeCompound(resultShape);
 
 
 
+namespace
+{
+   const char kSessionMagic[4] = { 'P', 'S', 'M', 'S' };
+   // 1: the three numbered slots; 2: any slots, by id; 3: adds the union and flip options
+   const std::uint32_t kSessionVersion = 3;
+
+   template <typename T>
+   void WritePod(std::ostream& out, const T& value) {
+      out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+   }
+
+   template <typename T>
+   T ReadPod(const char*& cursor, const char* end) {
+      if (end - cursor < static_cast<std::ptrdiff_t>(sizeof(T))) {
+         throw std::runtime_error("Session file is truncated.");
+      }
+      T value;
+      std::memcpy(&value, cursor, sizeof(T));
+      cursor += sizeof(T);
+      return value;
+   }
+}
+
+// Layout: magic, version, tracing flag, slot count, then per slot its length-prefixed id,
+// a presence flag, source format, generation and 3x4 placement matrix, followed by the
+// length-prefixed BinTools blobs of the present shapes. Triangulations are left out; they
+// are rebuilt on display. Version 1 files had exactly the left, right and fused slots.
+void IGESHandler::SaveSession(const std::string& filePath) {
+   PROSMART_TRACE_SCOPE("SaveSession");
+   const std::vector<std::string> ids = mpIGESHandlerPimpl->GetSlotIds();
+
+   std::ofstream out(filePath, std::ios::binary | std::ios::trunc);
+   if (!out) {
+      throw std::runtime_error("Failed to create session file: " + filePath);
+   }
+   out.write(kSessionMagic, sizeof(kSessionMagic));
+   WritePod(out, kSessionVersion);
+   WritePod(out, static_cast<std::uint8_t>(IGESTrace::IsEnabled()));
+   // The options the saved fused shape was made with, so a restored session unites alike
+   WritePod(out, static_cast<std::uint8_t>(mpIGESHandlerPimpl->GetUnionMode()));
+   WritePod(out, static_cast<std::uint8_t>(mpIGESHandlerPimpl->GetFlipTest()));
+   WritePod(out, static_cast<std::uint8_t>(mpIGESHandlerPimpl->GetSpeculativeUnion()));
+   WritePod(out, static_cast<std::uint32_t>(ids.size()));
+
+   for (const std::string& id : ids) {
+      WritePod(out, static_cast<std::uint32_t>(id.size()));
+      out.write(id.data(), id.size());
+      WritePod(out, static_cast<std::uint8_t>(!mpIGESHandlerPimpl->GetSlotShape(id).IsNull()));
+      WritePod(out, static_cast<std::uint8_t>(mpIGESHandlerPimpl->GetSourceFormat(id)));
+      WritePod(out, mpIGESHandlerPimpl->GetGeneration(id));
+      const gp_Trsf placement = mpIGESHandlerPimpl->GetPlacement(id);
+      for (int row = 1; row <= 3; ++row) {
+         for (int col = 1; col <= 4; ++col) WritePod(out, placement.Value(row, col));
+      }
+   }
+
+   for (const std::string& id : ids) {
+      const TopoDS_Shape& shape = mpIGESHandlerPimpl->GetSlotShape(id);
+      if (shape.IsNull()) continue;
+      std::ostringstream blob(std::ios::out | std::ios::binary);
+      BinTools::Write(shape, blob, Standard_False, Standard_False, BinTools_FormatVersion_CURRENT);
+      const std::string data = blob.str();
+      WritePod(out, static_cast<std::uint64_t>(data.size()));
+      out.write(data.data(), data.size());
+   }
+
+   if (!out) {
+      throw std::runtime_error("Failed to write session file: " + filePath);
+   }
+}
+
+void IGESHandler::RestoreSession(const std::string& filePath) {
+   PROSMART_TRACE_SCOPE("RestoreSession");
+   MappedFile file(filePath);
+   const char* cursor = file.Data();
+   const char* end = cursor + file.Size();
+
+   if (file.Size() < sizeof(kSessionMagic) || std::memcmp(cursor, kSessionMagic, sizeof(kSessionMagic)) != 0) {
+      throw std::runtime_error("Not a session file: " + filePath);
+   }
+   cursor += sizeof(kSessionMagic);
+   const std::uint32_t version = ReadPod<std::uint32_t>(cursor, end);
+   if (version < 1 || version > kSessionVersion) {
+      throw std::runtime_error("Unsupported session file version: " + filePath);
+   }
+   const bool tracing = ReadPod<std::uint8_t>(cursor, end) != 0;
+   // Older files keep the current options
+   std::optional<UnionMode> unionMode;
+   std::optional<FlipTest> flipTest;
+   std::optional<bool> speculate;
+   if (version >= 3) {
+      const std::uint8_t mode = ReadPod<std::uint8_t>(cursor, end);
+      const std::uint8_t test = ReadPod<std::uint8_t>(cursor, end);
+      if (mode > static_cast<std::uint8_t>(UnionMode::SeamLocal) || test > static_cast<std::uint8_t>(FlipTest::RayGrid)) {
+         throw std::runtime_error("Session file has unknown options: " + filePath);
+      }
+      unionMode = static_cast<UnionMode>(mode);
+      flipTest = static_cast<FlipTest>(test);
+      speculate = ReadPod<std::uint8_t>(cursor, end) != 0;
+   }
+   const std::uint32_t nSlots = version == 1 ? 3 : ReadPod<std::uint32_t>(cursor, end);
+
+   struct SavedSlot {
+      std::string id;
+      bool present = false;
+      ShapeFormat format = ShapeFormat::Unknown;
+      std::uint64_t generation = 0;
+      gp_Trsf placement;
+      TopoDS_Shape shape;
+   };
+   std::vector<SavedSlot> slots(nSlots);
+   for (std::uint32_t i = 0; i < nSlots; ++i) {
+      SavedSlot& slot = slots[i];
+      if (version == 1) {
+         slot.id = SlotId(static_cast<int>(i));
+      }
+      else {
+         const std::uint32_t length = ReadPod<std::uint32_t>(cursor, end);
+         if (static_cast<std::uint64_t>(end - cursor) < length) {
+            throw std::runtime_error("Session file is truncated: " + filePath);
+         }
+         slot.id.assign(cursor, length);
+         cursor += length;
+      }
+      slot.present = ReadPod<std::uint8_t>(cursor, end) != 0;
+      slot.format = static_cast<ShapeFormat>(ReadPod<std::uint8_t>(cursor, end));
+      slot.generation = ReadPod<std::uint64_t>(cursor, end);
+      double m[12];
+      for (double& value : m) value = ReadPod<double>(cursor, end);
+      slot.placement.SetValues(m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7], m[8], m[9], m[10], m[11]);
+   }
+
+   // Read everything before touching the current state so a bad file leaves the session intact
+   for (SavedSlot& slot : slots) {
+      if (!slot.present) continue;
+      const std::uint64_t length = ReadPod<std::uint64_t>(cursor, end);
+      if (static_cast<std::uint64_t>(end - cursor) < length) {
+         throw std::runtime_error("Session file is truncated: " + filePath);
+      }
+      MemoryStreamBuf buffer(cursor, static_cast<std::size_t>(length));
+      std::istream in(&buffer);
+      BinTools::Read(slot.shape, in);
+      if (slot.shape.IsNull()) {
+         throw std::runtime_error("Failed to read a shape from session file: " + filePath);
+      }
+      cursor += length;
+   }
+
+   // Restored shapes keep their saved generations; caches keyed by generation are dropped
+   // so none of them is reused for a different shape
+   for (const std::string& id : mpIGESHandlerPimpl->GetSlotIds()) mpIGESHandlerPimpl->RemoveSlot(id);
+   mpIGESHandlerPimpl->ForgetGenerations();
+   for (const SavedSlot& slot : slots) {
+      mpIGESHandlerPimpl->SetLoadedShape(slot.id, slot.shape, slot.format);
+      mpIGESHandlerPimpl->SetPlacement(slot.id, slot.placement);
+      mpIGESHandlerPimpl->RestoreGeneration(slot.id, slot.generation);
+   }
+   EnableTracing(tracing);
+   if (unionMode) SetUnionMode(*unionMode);
+   if (flipTest) SetFlipTest(*flipTest);
+   if (speculate) SetSpeculativeUnion(*speculate);
+   std::cout << "Session restored from " << filePath << std::endl;
+}
+
+void IGESHandler::SetFlipTest(FlipTest test) {
+   mpIGESHandlerPimpl->SetFlipTest(test);
+}
+
+void IGESHandler::SetSpeculativeUnion(bool enable) {
+   mpIGESHandlerPimpl->SetSpeculativeUnion(enable);
+}
+
+void IGESHandler::SetUnionMode(UnionMode mode) {
+   mpIGESHandlerPimpl->SetUnionMode(mode);
+}
+
+void IGESHandler::EnableTracing(bool enable) {
+   IGESTrace::SetEnabled(enable);
+}
+
+void IGESHandler::WriteTrace(const std::string& filePath) {
+   IGESTrace::WriteChromeTrace(filePath);
+   std::cout << "Trace written to: " << filePath << std::endl;
+}
+
 void IGESHandler::SaveAsIGS(const std::string& filePath) {
+   PROSMART_TRACE_SCOPE("SaveAsIGS");
    // Check if mFusedShape is initialized
    if (mpIGESHandlerPimpl->GetFusedShape().IsNull()) {
       throw std::runtime_error("Fused shape is not initialized or empty.");
@@ -1680,6 +3929,8 @@ void IGESHandler::SaveAsIGS(const std::string& filePath) {
    }
 
    // Write mFusedShape to an IGES file
+   PROSMART_TRACE_SCOPE("SaveAsIGS/Write");
+   std::lock_guard<std::mutex> lock(TranslatorMutex());
    IGESControl_Writer writer;
    writer.AddShape(mpIGESHandlerPimpl->GetFusedShape());
 
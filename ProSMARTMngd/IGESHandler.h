@@ -1,13 +1,87 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
+#include "IGESExportJob.h"
+#include "IGESMassProperties.h"
+#include "IGESInterference.h"
+#include "IGESSlicer.h"
+#include "IGESAlignment.h"
 
 class TopoDS_Shape; // Forward declaration
 class TCollection_AsciiString;
 class IGESHandler_PIMPL; // Forward declaration
 class gp_Pnt;
 class gp_Dir;
+
+// CAD exchange formats understood by the load/save paths
+enum class ShapeFormat
+{
+    Unknown,
+    IGES,
+    STEP,
+    BRep,
+    STL
+};
+
+// One output of a multi-format export
+struct ExportTarget
+{
+    ShapeFormat format = ShapeFormat::IGES;
+    std::string filePath;
+};
+
+struct ExportResult
+{
+    ShapeFormat format = ShapeFormat::IGES;
+    std::string filePath;
+    bool succeeded = false;
+    std::string error;
+    double seconds = 0;
+};
+
+// Accumulated import and union cost for parts coming from one format
+struct FormatTimings
+{
+    ShapeFormat format = ShapeFormat::Unknown;
+    int loads = 0;
+    double loadSeconds = 0;
+    int unions = 0;
+    double unionSeconds = 0;
+};
+
+// What lies under a pixel of the interactive view
+struct PickResult
+{
+    bool hit = false;
+    int order = -1;     // Numbered slot of the shape hit (see IGESHandler::SlotId), -1 for a named slot
+    std::string slot;   // Id of the slot hit
+    int faceIndex = 0;  // 1-based, in TopExp::MapShapes(shape, TopAbs_FACE) order
+    int edgeIndex = 0;  // 1-based, in TopExp::MapShapes(shape, TopAbs_EDGE) order; 0 if no edge is near
+    double x = 0, y = 0, z = 0;
+};
+
+// A named shape slot and the data derived from its current shape
+struct ShapeSlotInfo
+{
+    std::string id;
+    bool loaded = false;
+    ShapeFormat format = ShapeFormat::Unknown;
+    std::uint64_t generation = 0; // Changes whenever the slot's shape is replaced
+    bool valid = false;           // BRepCheck_Analyzer verdict, cached per generation
+    double bounds[6] = {};        // xmin, ymin, zmin, xmax, ymax, zmax; zero when empty
+};
+
+// How UnionShapes unites the left part with its mirrored copy
+enum class UnionMode
+{
+    Full,     // One Boolean on the two whole halves
+    SeamLocal // Boolean on the slabs at the mirror plane only; falls back to Full if that fails.
+              // The glue, validity check, interference test and mass properties still see the
+              // whole halves; the benchmark times both modes as UnionShapes[/SeamLocal].
+};
+
 class IGESHandler
 {
 private:
@@ -39,8 +113,70 @@ public:
     // Function to save an IGES file
     void SaveIGES(const std::string& filePath, int order=0);
 
+    // Format from the file extension, falling back to the IGES/STEP file header
+    static ShapeFormat DetectFormat(const std::string& filePath);
+
+    // Register the IGES and STEP translator controllers, once per process. Code that reads or
+    // writes from several threads calls this before starting them; the loaders call it too.
+    static void InitTranslators();
+
+    // Load or save through the reader/writer matching the file format
+    void LoadShape(const std::string& filePath, int order = 0);
+    void SaveShape(const std::string& filePath, int order = 0);
+
+    void LoadSTEP(const std::string& filePath, int order = 0);
+    void SaveSTEP(const std::string& filePath, int order = 0);
+
+    // Validate and triangulate the shape once, then write every target concurrently.
+    // A failing writer is reported in its result and does not stop the others.
+    std::vector<ExportResult> ExportAll(int order, const std::vector<ExportTarget>& targets, double linearDeflection = 0.1);
+
+    // Serialize a shape into an in-memory IGES, STEP or BRep file
+    std::vector<unsigned char> ExportToMemory(int order, ShapeFormat format = ShapeFormat::IGES);
+
+    // Same, on a background thread; the shape is captured when the call is made
+    IGESExportJob ExportToMemoryAsync(int order, ShapeFormat format = ShapeFormat::IGES);
+
+    // Shapes live in named slots. The numbered orders taken by the other methods are the slots
+    // "left" (0), "right" (1), "fused" (2) and "mirrored" (3); any other id adds a slot of its own,
+    // so many parts can stay loaded at once.
+    static std::string SlotId(int order);
+    static int SlotOrder(const std::string& id); // -1 for a slot without a number
+    std::vector<std::string> GetSlotIds() const;
+    ShapeSlotInfo GetSlotInfo(const std::string& id);
+    void LoadSlot(const std::string& id, const std::string& filePath);
+    void RemoveSlot(const std::string& id);
+
+    // Fuse the shapes of several slots into resultId; the parts stay loaded for further unions
+    void UnionSlots(const std::vector<std::string>& ids, const std::string& resultId);
+
+    // Import and union timings per source format
+    std::vector<FormatTimings> GetFormatTimings() const;
+
+    // Volume, area, center, topology counts and edge length range of a shape; cached per shape
+    MassPropertiesReport GetMassProperties(int order);
+
+    // Overlap, contact and gap between two slots from their meshes; UnionShapes runs this on
+    // the left and mirrored parts before the fuse
+    InterferenceReport CheckInterference(int orderA = 0, int orderB = 3);
+
+    // Cross sections of a shape at the given stations along an axis, computed in parallel
+    SliceReport Slice(int order, const SliceOptions& options);
+
     // Function to align the part to the XY plane with its length along the X-axis
-    void AlignToXYPlane(int order=0);
+    void AlignToXYPlane(int order=0, AlignmentMode mode = AlignmentMode::AxisAligned);
+
+    // How AlignToXYPlane decides to turn the part over; FlipTest::SingleRay by default
+    void SetFlipTest(FlipTest test);
+
+    // Off by default. When on, aligning the left part starts its union on a low-priority
+    // thread once alignments have paused for a moment. UnionShapes adopts it (or its error)
+    // if it has finished on the unchanged part; one still running is cancelled and the union
+    // computed in the foreground. Any edit cancels it too.
+    void SetSpeculativeUnion(bool enable);
+
+    // UnionMode::Full by default
+    void SetUnionMode(UnionMode mode);
 
     // Function to compute the thumbnail view matrix for WPF PictureBox
     //void ComputeThumbnailMatrix(float matrix[4][4]);
@@ -52,19 +188,74 @@ public:
     std::vector<unsigned char> DumpInputShapes(const int width, const int height);
     std::vector<unsigned char> DumpFusedShape(const int width, const int height);
 
+    // Render the input parts (or the fused part) through a persistent offscreen view.
+    // Frames are top-down BGRA, width * height * 4 bytes.
+    std::vector<unsigned char> RenderView(int width, int height, bool fused);
+
+    // Camera-only changes to the persistent view; the scene is redisplayed only if a shape changed
+    std::vector<unsigned char> ZoomView(double factor);
+    std::vector<unsigned char> PanView(int dx, int dy);
+    std::vector<unsigned char> OrbitView(double angleXDegrees, double angleYDegrees);
+    std::vector<unsigned char> FitView();
+
+    // Face and edge under view pixel (x, y), from a BVH over the displayed meshes
+    PickResult Pick(int x, int y);
+
+    // Overlay the face under view pixel (x, y) and return the new frame; empty when the
+    // pointer is still over the face already overlaid, so nothing needs redrawing
+    std::vector<unsigned char> Hover(int x, int y);
+
+    // Highlight a face returned by Pick and return the new frame; faceIndex 0 clears it
+    std::vector<unsigned char> HighlightFace(int order, int faceIndex);
+
+    // Shapes are drawn from background-meshed levels of detail: the coarse level between
+    // BeginInteraction and EndInteraction, the finest one ready otherwise
+    void BeginInteraction();
+    std::vector<unsigned char> EndInteraction();
+
+    // Start meshing the levels of detail RenderView(fused) will draw, so the first frame
+    // does not start them on the rendering thread
+    void PrepareView(bool fused);
+
+    // Wait until the finest level of the displayed shapes is meshed; false on timeout
+    bool WaitForDetail(int timeoutMs);
+
+    // The finest level of detail of a numbered slot, meshed first if need be; null when empty
+    TopoDS_Shape GetDetailedMesh(int order);
+
     void ScrewRotationAboutMidPart(TopoDS_Shape& shape, const gp_Pnt& pt, const gp_Dir& axis, double angleDegrees);
 
     void   PerformZoomAndRender(bool zoomIn);
     void RotatePartBy180AboutZAxis(int order);
     void Redraw();
+    // Unites the left part with its mirrored copy. If the part has only been moved since the
+    // last union, by a translation or a rotation about X, the previous result is moved instead.
     void UnionShapes();
     void SaveAsIGS(const std::string& filePath);
     bool HasMultipleConnectedComponents(const TopoDS_Shape& shape);
     bool IsPointOnAnySurface(const TopoDS_Shape& shape, const gp_Pnt& point, double tolerance);
     bool DoesVectorIntersectShape(const TopoDS_Shape& shape, const gp_Pnt& point, const gp_Dir& direction, gp_Pnt& intersectionPoint);
     void Mirror();
-    void HandleIntersectingBoundingCurves(TopoDS_Shape& fusedShape, double tolerance);
+    void HandleIntersectingBoundingCurves(TopoDS_Shape& fusedShape, double tolerance, bool sewFaces = true, double fixPrecision = 1e-3);
     //double ShortestDistanceBetweenShapes(const TopoDS_Shape& shape1, const TopoDS_Shape& shape2, gp_Pnt& pointOnShape1, gp_Pnt& pointOnShape2);
     //void ExtractLargestSolid(const TopoDS_Shape& shape, TopoDS_Shape& largestShape);
     //void HandleMultipleConnectedComponents(TopoDS_Shape& fusedShape);
+
+    // Write the loaded, aligned and fused shapes with their placements, and the union, flip-test
+    // and speculation options, to a compact binary file
+    void SaveSession(const std::string& filePath);
+
+    // Replace the current state with a session written by SaveSession
+    void RestoreSession(const std::string& filePath);
+
+    // Turn the scoped trace spans on or off (off by default)
+    void EnableTracing(bool enable);
+
+    // Dump the recorded trace spans as Chrome/Perfetto trace JSON
+    void WriteTrace(const std::string& filePath);
+
+private:
+    // Readers behind the numbered and the named load entry points
+    void LoadIGESToSlot(const std::string& id, const std::string& filePath);
+    void LoadSTEPToSlot(const std::string& id, const std::string& filePath);
 };
\ No newline at end of file
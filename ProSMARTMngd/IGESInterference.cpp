@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include <omp.h>
+#include <BRepBndLib.hxx>
+#include <BRepBuilderAPI_Copy.hxx>
+#include <BRepMesh_IncrementalMesh.hxx>
+#include <Bnd_Box.hxx>
+#include <TopoDS_Shape.hxx>
+
+#include "IGESInterference.h"
+#include "IGESTrace.h"
+#include "MeshBVH.h"
+
+namespace
+{
+   // Closest point of triangle abc to p (Ericson, Real-Time Collision Detection 5.1.5)
+   gp_XYZ ClosestPointOnTriangle(const gp_XYZ& p, const gp_XYZ& a, const gp_XYZ& b, const gp_XYZ& c) {
+      const gp_XYZ ab = b - a, ac = c - a, ap = p - a;
+      const double d1 = ab.Dot(ap), d2 = ac.Dot(ap);
+      if (d1 <= 0 && d2 <= 0) return a;
+      const gp_XYZ bp = p - b;
+      const double d3 = ab.Dot(bp), d4 = ac.Dot(bp);
+      if (d3 >= 0 && d4 <= d3) return b;
+      const double vc = d1 * d4 - d3 * d2;
+      if (vc <= 0 && d1 >= 0 && d3 <= 0) return a + ab * (d1 / (d1 - d3));
+      const gp_XYZ cp = p - c;
+      const double d5 = ab.Dot(cp), d6 = ac.Dot(cp);
+      if (d6 >= 0 && d5 <= d6) return c;
+      const double vb = d5 * d2 - d1 * d6;
+      if (vb <= 0 && d2 >= 0 && d6 <= 0) return a + ac * (d2 / (d2 - d6));
+      const double va = d3 * d6 - d5 * d4;
+      if (va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0) return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+      const double sum = va + vb + vc;
+      if (sum <= 0) return a; // Degenerate triangle
+      return a + ab * (vb / sum) + ac * (vc / sum);
+   }
+
+   // Distance between segments p1q1 and p2q2 (Ericson 5.1.9)
+   double SegmentDistance(const gp_XYZ& p1, const gp_XYZ& q1, const gp_XYZ& p2, const gp_XYZ& q2) {
+      const double kEpsilon = 1e-18;
+      const gp_XYZ d1 = q1 - p1, d2 = q2 - p2, r = p1 - p2;
+      const double a = d1.SquareModulus(), e = d2.SquareModulus(), f = d2.Dot(r);
+      double s = 0, t = 0;
+      if (a <= kEpsilon && e <= kEpsilon) return r.Modulus();
+      if (a <= kEpsilon) {
+         t = std::clamp(f / e, 0.0, 1.0);
+      }
+      else {
+         const double c = d1.Dot(r);
+         if (e <= kEpsilon) {
+            s = std::clamp(-c / a, 0.0, 1.0);
+         }
+         else {
+            const double b = d1.Dot(d2);
+            const double denominator = a * e - b * b;
+            s = denominator > 0 ? std::clamp((b * f - c * e) / denominator, 0.0, 1.0) : 0.0;
+            t = (b * s + f) / e;
+            if (t < 0) {
+               t = 0;
+               s = std::clamp(-c / a, 0.0, 1.0);
+            }
+            else if (t > 1) {
+               t = 1;
+               s = std::clamp((b - c) / a, 0.0, 1.0);
+            }
+         }
+      }
+      return ((p1 + d1 * s) - (p2 + d2 * t)).Modulus();
+   }
+
+   bool SegmentCrossesTriangle(const gp_XYZ& p, const gp_XYZ& q, const MeshBVH::Triangle& triangle) {
+      double t, u, v;
+      return MeshBVH::IntersectTriangle(p, q - p, triangle, t, u, v) && t >= 0.0 && t <= 1.0;
+   }
+
+   // Distance between two triangles; 0 when they cross. Coplanar overlaps also come out as 0
+   // through the edge-edge distances.
+   double TriangleDistance(const MeshBVH::Triangle& a, const MeshBVH::Triangle& b, bool& crossing) {
+      const gp_XYZ pa[3] = { a.p0, a.p1, a.p2 };
+      const gp_XYZ pb[3] = { b.p0, b.p1, b.p2 };
+      crossing = false;
+      for (int i = 0; i < 3 && !crossing; ++i) {
+         crossing = SegmentCrossesTriangle(pa[i], pa[(i + 1) % 3], b) || SegmentCrossesTriangle(pb[i], pb[(i + 1) % 3], a);
+      }
+      if (crossing) return 0.0;
+
+      double distance = std::numeric_limits<double>::max();
+      for (int i = 0; i < 3; ++i) {
+         distance = std::min(distance, (pa[i] - ClosestPointOnTriangle(pa[i], b.p0, b.p1, b.p2)).Modulus());
+         distance = std::min(distance, (pb[i] - ClosestPointOnTriangle(pb[i], a.p0, a.p1, a.p2)).Modulus());
+         for (int j = 0; j < 3; ++j)
+            distance = std::min(distance, SegmentDistance(pa[i], pa[(i + 1) % 3], pb[j], pb[(j + 1) % 3]));
+      }
+      return distance;
+   }
+
+   double BoxDistance(const MeshBVH::Node& a, const MeshBVH::Node& b) {
+      double squared = 0;
+      for (int k = 1; k <= 3; ++k) {
+         const double gap = std::max({ 0.0, a.min.Coord(k) - b.max.Coord(k), b.min.Coord(k) - a.max.Coord(k) });
+         squared += gap * gap;
+      }
+      return std::sqrt(squared);
+   }
+
+   double BoxVolume(const MeshBVH::Node& node) {
+      const gp_XYZ size = node.max - node.min;
+      return size.X() * size.Y() * size.Z();
+   }
+
+   // Inside test for a closed mesh; the skewed direction keeps the ray off edges of axis-aligned meshes
+   bool IsInside(const MeshBVH& bvh, const gp_XYZ& point) {
+      static const gp_XYZ kDirection = gp_XYZ(0.5773, 0.5779, 0.5768).Normalized();
+      return (bvh.CountCrossings(point, kDirection) & 1) != 0;
+   }
+
+   void MeshCopy(const TopoDS_Shape& shape, double deflection, MeshBVH& bvh) {
+      // Mesh a copy so the stored triangulations of the part are left alone
+      TopoDS_Shape copy = BRepBuilderAPI_Copy(shape, Standard_True, Standard_False).Shape();
+      BRepMesh_IncrementalMesh mesher(copy, deflection, Standard_False, 0.5, Standard_True);
+      bvh.Build(copy);
+   }
+}
+
+InterferenceReport IGESInterference::Check(const TopoDS_Shape& a, const TopoDS_Shape& b, const InterferenceOptions& options)
+{
+   PROSMART_TRACE_SCOPE("Interference");
+   auto start = std::chrono::steady_clock::now();
+   InterferenceReport report;
+
+   Bnd_Box boxA, boxB;
+   BRepBndLib::Add(a, boxA);
+   BRepBndLib::Add(b, boxB);
+   if (boxA.IsVoid() || boxB.IsVoid()) throw std::runtime_error("Interference check needs two non-empty shapes.");
+   const double diagonal = std::max(std::sqrt(boxA.SquareExtent()), std::sqrt(boxB.SquareExtent()));
+   const double deflection = options.relativeDeflection * diagonal;
+   report.tolerance = options.contactTolerance + 2 * deflection; // Each mesh may sit a deflection off its surface
+
+   MeshBVH bvhA, bvhB;
+   {
+      PROSMART_TRACE_SCOPE("Interference/Mesh");
+      MeshCopy(a, deflection, bvhA);
+      MeshCopy(b, deflection, bvhB);
+   }
+   if (bvhA.IsEmpty() || bvhB.IsEmpty()) throw std::runtime_error("Interference check could not mesh the shapes.");
+   report.nTriangles[0] = static_cast<int>(bvhA.Triangles().size());
+   report.nTriangles[1] = static_cast<int>(bvhB.Triangles().size());
+
+   // Walk both hierarchies together, pruning node pairs that can neither bring the minimum
+   // distance down nor lie within the contact tolerance
+   const std::vector<MeshBVH::Node>& nodesA = bvhA.Nodes();
+   const std::vector<MeshBVH::Node>& nodesB = bvhB.Nodes();
+   double minDistance = std::numeric_limits<double>::max();
+   bool crossing = false;
+   gp_XYZ contactMin(Precision::Infinite(), Precision::Infinite(), Precision::Infinite());
+   gp_XYZ contactMax = contactMin.Reversed();
+   {
+      PROSMART_TRACE_SCOPE("Interference/Traverse");
+      std::vector<std::pair<int, int>> stack = { { 0, 0 } };
+      while (!stack.empty()) {
+         const auto [i, j] = stack.back();
+         stack.pop_back();
+         const MeshBVH::Node& nodeA = nodesA[i];
+         const MeshBVH::Node& nodeB = nodesB[j];
+         const double boxDistance = BoxDistance(nodeA, nodeB);
+         if (boxDistance > report.tolerance && boxDistance >= minDistance) continue;
+
+         if (nodeA.count > 0 && nodeB.count > 0) {
+            for (int ta = nodeA.first; ta < nodeA.first + nodeA.count; ++ta) {
+               for (int tb = nodeB.first; tb < nodeB.first + nodeB.count; ++tb) {
+                  const MeshBVH::Triangle& triangleA = bvhA.Triangles()[ta];
+                  const MeshBVH::Triangle& triangleB = bvhB.Triangles()[tb];
+                  bool crosses;
+                  const double distance = TriangleDistance(triangleA, triangleB, crosses);
+                  crossing = crossing || crosses;
+                  minDistance = std::min(minDistance, distance);
+                  if (distance > report.tolerance) continue;
+                  ++report.nContactPairs;
+                  for (const gp_XYZ& p : { triangleA.p0, triangleA.p1, triangleA.p2, triangleB.p0, triangleB.p1, triangleB.p2 }) {
+                     for (int k = 1; k <= 3; ++k) {
+                        contactMin.SetCoord(k, std::min(contactMin.Coord(k), p.Coord(k)));
+                        contactMax.SetCoord(k, std::max(contactMax.Coord(k), p.Coord(k)));
+                     }
+                  }
+               }
+            }
+         }
+         else if (nodeB.count > 0 || (nodeA.count == 0 && BoxVolume(nodeA) >= BoxVolume(nodeB))) {
+            // Split the larger inner node
+            stack.push_back({ nodeA.left, j });
+            stack.push_back({ nodeA.right, j });
+         }
+         else {
+            stack.push_back({ i, nodeB.left });
+            stack.push_back({ i, nodeB.right });
+         }
+      }
+   }
+   report.minDistance = crossing ? 0.0 : minDistance;
+   if (report.nContactPairs > 0) {
+      report.hasContact = true;
+      for (int k = 0; k < 3; ++k) {
+         report.contactMin[k] = contactMin.Coord(k + 1);
+         report.contactMax[k] = contactMax.Coord(k + 1);
+      }
+   }
+
+   // Without crossing surfaces the volumes overlap only if one part holds the other
+   const bool contained = !crossing && (IsInside(bvhB, bvhA.Triangles().front().p0) || IsInside(bvhA, bvhB.Triangles().front().p0));
+
+   if (crossing || contained) {
+      // Count grid points inside both meshes over the common box
+      PROSMART_TRACE_SCOPE("Interference/Volume");
+      gp_XYZ low, high;
+      for (int k = 1; k <= 3; ++k) {
+         low.SetCoord(k, std::max(nodesA[0].min.Coord(k), nodesB[0].min.Coord(k)));
+         high.SetCoord(k, std::min(nodesA[0].max.Coord(k), nodesB[0].max.Coord(k)));
+      }
+      const int n = std::max(2, options.volumeSamples);
+      const gp_XYZ cell = (high - low) / n;
+      int inside = 0;
+#pragma omp parallel for schedule(dynamic, 1) reduction(+ : inside)
+      for (int iz = 0; iz < n; ++iz) {
+         for (int iy = 0; iy < n; ++iy) {
+            for (int ix = 0; ix < n; ++ix) {
+               const gp_XYZ point = low + gp_XYZ(cell.X() * (ix + 0.5), cell.Y() * (iy + 0.5), cell.Z() * (iz + 0.5));
+               if (IsInside(bvhA, point) && IsInside(bvhB, point)) ++inside;
+            }
+         }
+      }
+      report.overlapVolume = inside * cell.X() * cell.Y() * cell.Z();
+   }
+
+   if (contained || (crossing && report.overlapVolume > 0)) report.kind = InterferenceKind::Overlapping;
+   else if (report.nContactPairs > 0) report.kind = InterferenceKind::Touching;
+   else report.kind = InterferenceKind::Apart;
+
+   report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   return report;
+}
+
+std::string IGESInterference::Format(const InterferenceReport& report)
+{
+   const char* kind = report.kind == InterferenceKind::Overlapping ? "overlapping"
+      : report.kind == InterferenceKind::Touching ? "touching" : "apart";
+   char line[512];
+   int length = std::snprintf(line, sizeof(line),
+      "%s, min distance %.4g (tolerance %.3g), overlap volume %.4g, %d contact pairs, %d/%d triangles, %.1f ms",
+      kind, report.minDistance, report.tolerance, report.overlapVolume, report.nContactPairs,
+      report.nTriangles[0], report.nTriangles[1], report.seconds * 1000.0);
+   if (report.hasContact && length > 0 && length < static_cast<int>(sizeof(line))) {
+      std::snprintf(line + length, sizeof(line) - length, ", contact box (%.3f, %.3f, %.3f)-(%.3f, %.3f, %.3f)",
+         report.contactMin[0], report.contactMin[1], report.contactMin[2],
+         report.contactMax[0], report.contactMax[1], report.contactMax[2]);
+   }
+   return line;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+
+class TopoDS_Shape;
+
+enum class InterferenceKind
+{
+   Apart,       // A gap wider than the tolerance: a fuse gives two solids
+   Touching,    // Surfaces meet within the tolerance but the volumes do not overlap
+   Overlapping  // Surfaces cross, or one part contains the other
+};
+
+struct InterferenceOptions
+{
+   double relativeDeflection = 2e-3; // Mesh deflection as a fraction of the larger part diagonal
+   double contactTolerance = 1e-2;   // Gap still counted as contact, on top of the mesh deflection
+   int volumeSamples = 32;           // Grid points per axis for the overlap volume estimate
+};
+
+struct InterferenceReport
+{
+   InterferenceKind kind = InterferenceKind::Apart;
+   double minDistance = 0;   // Between the meshes; 0 when they cross
+   double tolerance = 0;     // Contact tolerance used, mesh deflection included
+   double overlapVolume = 0; // Estimate; 0 unless overlapping
+   bool hasContact = false;  // The contact box below is set
+   double contactMin[3] = { 0, 0, 0 };
+   double contactMax[3] = { 0, 0, 0 };
+   int nContactPairs = 0;    // Triangle pairs closer than the tolerance
+   int nTriangles[2] = { 0, 0 };
+   double seconds = 0;
+};
+
+// Pre-flight check for a Boolean between two parts: both are meshed coarsely and their
+// triangle BVHs traversed together, so the answer takes milliseconds instead of a fuse.
+class IGESInterference
+{
+public:
+   static InterferenceReport Check(const TopoDS_Shape& a, const TopoDS_Shape& b, const InterferenceOptions& options = InterferenceOptions());
+
+   // One line, for logs
+   static std::string Format(const InterferenceReport& report);
+};
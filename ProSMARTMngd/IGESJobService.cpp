@@ -0,0 +1,556 @@
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <Standard_Failure.hxx>
+
+#include "IGESJobService.h"
+#include "IGESHandler.h"
+#include "IGESSessionEngine.h"
+#include "IGESTrace.h"
+
+#pragma comment(lib, "Ws2_32.lib")
+
+namespace
+{
+   // WSAStartup is reference counted, so the server and every client hold their own
+   struct WinsockScope
+   {
+      WinsockScope() {
+         WSADATA data;
+         if (WSAStartup(MAKEWORD(2, 2), &data) != 0) throw std::runtime_error("Winsock initialization failed.");
+      }
+      ~WinsockScope() { WSACleanup(); }
+   };
+
+   void SendLine(SOCKET socket, const std::string& text) {
+      const std::string line = text + "\n";
+      for (std::size_t sent = 0; sent < line.size();) {
+         const int n = send(socket, line.data() + sent, static_cast<int>(line.size() - sent), 0);
+         if (n <= 0) throw std::runtime_error("Connection lost while sending.");
+         sent += n;
+      }
+   }
+
+   // False once the peer has closed the connection; throws on a line longer than
+   // kMaxRequestLength, so a peer cannot make the reader buffer without limit
+   bool ReadLine(SOCKET socket, std::string& pending, std::string& line) {
+      for (;;) {
+         const std::size_t end = pending.find('\n');
+         if (end != std::string::npos) {
+            line = pending.substr(0, end);
+            pending.erase(0, end + 1);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            return true;
+         }
+         if (pending.size() > kMaxRequestLength) {
+            throw std::runtime_error("A line is longer than " + std::to_string(kMaxRequestLength) + " bytes.");
+         }
+         char buffer[4096];
+         const int n = recv(socket, buffer, sizeof(buffer), 0);
+         if (n <= 0) return false;
+         pending.append(buffer, n);
+      }
+   }
+
+   // Paths are the last argument and may contain spaces
+   std::string RestOfLine(std::istringstream& in) {
+      std::string rest;
+      std::getline(in, rest);
+      const std::size_t start = rest.find_first_not_of(' ');
+      if (start == std::string::npos) throw std::runtime_error("A path is missing.");
+      return rest.substr(start);
+   }
+
+   int ReadNumber(std::istringstream& in, const char* what) {
+      int value = 0;
+      if (!(in >> value)) throw std::runtime_error(std::string("A ") + what + " number is missing.");
+      return value;
+   }
+
+   int NumberedSlot(const std::string& id) {
+      const int order = IGESHandler::SlotOrder(id);
+      if (order < 0) throw std::runtime_error("Slot " + id + " has no number; use left, right, fused or mirrored.");
+      return order;
+   }
+
+   std::string FailureMessage() {
+      try {
+         throw;
+      }
+      catch (const Standard_Failure& failure) {
+         return failure.GetMessageString() != nullptr && *failure.GetMessageString() != '\0' ? failure.GetMessageString() : "Geometry kernel error.";
+      }
+      catch (const std::exception& ex) {
+         return ex.what();
+      }
+      catch (...) {
+         return "Unknown error.";
+      }
+   }
+
+   std::string RandomToken() {
+      std::random_device random;
+      std::ostringstream out;
+      out << std::hex;
+      for (int i = 0; i < 4; ++i) out << random();
+      return out.str();
+   }
+
+   class JobServer
+   {
+   public:
+      explicit JobServer(const JobServiceOptions& options) : mOptions(options) {
+         if (mOptions.shutdownToken.empty()) mOptions.shutdownToken = RandomToken();
+      }
+
+      void Run() {
+         WinsockScope winsock;
+         mListener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+         if (mListener == INVALID_SOCKET) throw std::runtime_error("Failed to create the service socket.");
+         sockaddr_in address{};
+         address.sin_family = AF_INET;
+         address.sin_port = htons(static_cast<u_short>(mOptions.port));
+         inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+         if (bind(mListener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(mListener, SOMAXCONN) != 0) {
+            closesocket(mListener);
+            throw std::runtime_error("Failed to listen on port " + std::to_string(mOptions.port) + ".");
+         }
+         std::cout << "Job service listening on 127.0.0.1:" << mOptions.port << " (" << mOptions.queueCapacity
+            << " jobs, " << mOptions.maxSessions << " sessions); shutdown token " << mOptions.shutdownToken << std::endl;
+
+         // Stop() closes the listener from another thread, so accept on a copy
+         const SOCKET listener = mListener;
+         std::vector<ConnectionThread> connections;
+         for (;;) {
+            SOCKET client = accept(listener, nullptr, nullptr);
+
+            // Join the threads of connections that have ended, so a long-running service
+            // does not keep one per client it ever had
+            for (auto it = connections.begin(); it != connections.end();) {
+               if (*it->finished) {
+                  it->thread.join();
+                  it = connections.erase(it);
+               }
+               else {
+                  ++it;
+               }
+            }
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (client == INVALID_SOCKET || mStopping) {
+               if (client != INVALID_SOCKET) closesocket(client);
+               break;
+            }
+            mClients.insert(client);
+            auto finished = std::make_shared<std::atomic<bool>>(false);
+            connections.push_back({ std::thread([this, client, finished] {
+               ServeConnection(client);
+               *finished = true;
+            }), finished });
+         }
+         Stop();
+         for (ConnectionThread& connection : connections) connection.thread.join();
+         std::cout << "Job service stopped: " << Stats() << std::endl;
+      }
+
+   private:
+      struct ConnectionThread {
+         std::thread thread;
+         std::shared_ptr<std::atomic<bool>> finished;
+      };
+
+      // What one connection owns; it goes with the connection
+      struct Connection {
+         std::vector<int> sessions;           // Closed when the connection drops
+         std::map<int, IGESSessionJob> jobs;  // Accepted and not yet reported
+         bool stopService = false;            // SHUTDOWN was accepted
+      };
+
+      // One of the maxSessions places, given back when this goes unless Keep() was called
+      struct SessionPlace {
+         JobServer* server;
+         ~SessionPlace() {
+            if (server != nullptr) server->ReleaseSession();
+         }
+         void Keep() { server = nullptr; }
+      };
+
+      void ReleaseSession() {
+         std::lock_guard<std::mutex> lock(mMutex);
+         --mOpenSessions;
+      }
+
+      void Stop() {
+         std::lock_guard<std::mutex> lock(mMutex);
+         mStopping = true;
+         if (mListener != INVALID_SOCKET) {
+            closesocket(mListener); // Wakes the accept loop
+            mListener = INVALID_SOCKET;
+         }
+         for (SOCKET client : mClients) shutdown(client, SD_BOTH); // Wakes blocked reads
+      }
+
+      void ServeConnection(SOCKET client) {
+         Connection connection;
+         try {
+            std::string pending, line;
+            while (ReadLine(client, pending, line)) {
+               std::string reply;
+               try {
+                  reply = Handle(line, connection);
+               }
+               catch (...) {
+                  reply = "ERR " + FailureMessage();
+               }
+               SendLine(client, reply);
+               if (connection.stopService) {
+                  Stop();
+                  break;
+               }
+            }
+         }
+         catch (const std::exception& ex) {
+            std::cerr << "Job service connection: " << ex.what() << std::endl;
+         }
+         for (int session : connection.sessions) CloseSession(session);
+         std::lock_guard<std::mutex> lock(mMutex);
+         mClients.erase(client);
+         closesocket(client);
+      }
+
+      std::string Handle(const std::string& line, Connection& connection) {
+         PROSMART_TRACE_SCOPE("JobService/Request");
+         std::istringstream in(line);
+         std::string command;
+         in >> command;
+
+         if (command == "OPEN") {
+            {
+               std::lock_guard<std::mutex> lock(mMutex);
+               if (mOpenSessions >= mOptions.maxSessions) return "BUSY";
+               ++mOpenSessions;
+            }
+            SessionPlace place{ this };
+            connection.sessions.reserve(connection.sessions.size() + 1); // So the push below cannot throw
+            const int session = mEngine.OpenSession();
+            connection.sessions.push_back(session);
+            place.Keep();
+            return "OK " + std::to_string(session);
+         }
+         if (command == "CLOSE") {
+            const int session = OwnedSession(in, connection.sessions);
+            connection.sessions.erase(std::find(connection.sessions.begin(), connection.sessions.end(), session));
+            CloseSession(session);
+            return "OK";
+         }
+         if (command == "STATUS" || command == "WAIT") {
+            return Report(ReadNumber(in, "job"), command == "WAIT", connection);
+         }
+         if (command == "STATS") return "OK " + Stats();
+         if (command == "SHUTDOWN") {
+            std::string token;
+            in >> token;
+            if (token != mOptions.shutdownToken) throw std::runtime_error("SHUTDOWN needs the token the service printed when it started.");
+            connection.stopService = true;
+            return "OK";
+         }
+
+         // Everything else is a job; its arguments are checked before it is queued
+         static const std::set<std::string> jobCommands = { "LOAD", "ALIGN", "UNION", "UNIONSLOTS", "EXPORT" };
+         if (jobCommands.count(command) == 0) throw std::runtime_error("Unknown command: " + command);
+         const int session = OwnedSession(in, connection.sessions);
+         if (command == "LOAD") {
+            std::string slot;
+            in >> slot;
+            const std::string path = RestOfLine(in);
+            return SubmitJob(connection, session, [slot, path](IGESHandler& handler) { handler.LoadSlot(slot, path); });
+         }
+         if (command == "ALIGN") {
+            std::string slot;
+            in >> slot;
+            const int order = NumberedSlot(slot);
+            if (order > 1) throw std::runtime_error("Only the left and right slots can be aligned.");
+            return SubmitJob(connection, session, [order](IGESHandler& handler) { handler.AlignToXYPlane(order); });
+         }
+         if (command == "UNION") {
+            return SubmitJob(connection, session, [](IGESHandler& handler) { handler.UnionShapes(); });
+         }
+         if (command == "UNIONSLOTS") {
+            std::string result, slot;
+            std::vector<std::string> slots;
+            in >> result;
+            while (in >> slot) slots.push_back(slot);
+            return SubmitJob(connection, session, [result, slots](IGESHandler& handler) { handler.UnionSlots(slots, result); });
+         }
+         // EXPORT
+         std::string slot;
+         in >> slot;
+         const int order = NumberedSlot(slot);
+         const std::string path = RestOfLine(in);
+         return SubmitJob(connection, session, [order, path](IGESHandler& handler) { handler.SaveShape(path, order); });
+      }
+
+      int OwnedSession(std::istringstream& in, const std::vector<int>& sessions) {
+         const int session = ReadNumber(in, "session");
+         if (std::find(sessions.begin(), sessions.end(), session) == sessions.end()) {
+            throw std::runtime_error("Session " + std::to_string(session) + " was not opened on this connection.");
+         }
+         return session;
+      }
+
+      void CloseSession(int session) {
+         SessionPlace place{ this }; // Given back even if closing throws
+         mEngine.CloseSession(session); // Waits for the session's jobs
+      }
+
+      // Back-pressure: a place in the queue is reserved before the job is queued, so
+      // concurrent clients cannot push the service past its capacity
+      std::string SubmitJob(Connection& connection, int session, std::function<void(IGESHandler&)> work) {
+         std::size_t inflight = mInflight.load();
+         do {
+            if (inflight >= mOptions.queueCapacity) {
+               ++mRefused;
+               return "BUSY";
+            }
+         } while (!mInflight.compare_exchange_weak(inflight, inflight + 1));
+
+         IGESSessionJob job;
+         try {
+            job = mEngine.Submit(session, [this, work = std::move(work)](IGESHandler& handler) {
+               try {
+                  work(handler);
+               }
+               catch (...) {
+                  --mInflight;
+                  throw;
+               }
+               --mInflight;
+            });
+         }
+         catch (...) {
+            --mInflight;
+            throw;
+         }
+         ++mAccepted;
+         const int id = mNextJob++;
+         connection.jobs.emplace(id, job);
+         return "OK " + std::to_string(id);
+      }
+
+      // Only jobs submitted on the asking connection can be reported
+      std::string Report(int id, bool wait, Connection& connection) {
+         auto it = connection.jobs.find(id);
+         if (it == connection.jobs.end()) throw std::runtime_error("No job " + std::to_string(id) + " is pending on this connection.");
+         const IGESSessionJob job = it->second;
+         if (!wait && !job.IsReady()) return "PENDING";
+
+         std::string reply;
+         bool failed = false;
+         try {
+            const SessionJobTimings timings = job.Get();
+            std::ostringstream out;
+            out << "DONE " << timings.queuedSeconds * 1000.0 << " " << timings.runSeconds * 1000.0;
+            reply = out.str();
+         }
+         catch (...) {
+            reply = "FAILED " + FailureMessage();
+            failed = true;
+         }
+         connection.jobs.erase(id);
+         ++(failed ? mFailed : mDone);
+         return reply;
+      }
+
+      std::string Stats() {
+         std::ostringstream out;
+         out << "accepted=" << mAccepted << " refused=" << mRefused << " done=" << mDone
+            << " failed=" << mFailed << " inflight=" << mInflight;
+         return out.str();
+      }
+
+      JobServiceOptions mOptions;
+      IGESSessionEngine mEngine;
+      std::mutex mMutex;
+      SOCKET mListener = INVALID_SOCKET;
+      bool mStopping = false;
+      std::set<SOCKET> mClients;
+      int mOpenSessions = 0;
+      std::atomic<int> mNextJob{ 1 };
+      std::atomic<std::size_t> mInflight{ 0 };
+      std::atomic<int> mAccepted{ 0 }, mRefused{ 0 }, mDone{ 0 }, mFailed{ 0 };
+   };
+
+   int ParseOk(const std::string& reply, const std::string& request) {
+      if (reply.compare(0, 3, "OK ") != 0) throw std::runtime_error(request + ": " + reply);
+      return std::stoi(reply.substr(3));
+   }
+
+   double Percentile(std::vector<double> values, double fraction) {
+      if (values.empty()) return 0;
+      std::sort(values.begin(), values.end());
+      return values[std::min(values.size() - 1, static_cast<std::size_t>(fraction * values.size()))];
+   }
+}
+
+void IGESJobService::Serve(const JobServiceOptions& options)
+{
+   JobServer server(options);
+   server.Run();
+}
+
+LoadGeneratorReport IGESJobService::RunLoadGenerator(const LoadGeneratorOptions& options)
+{
+   namespace fs = std::filesystem;
+   fs::create_directories(options.outputDir);
+
+   std::mutex mutex;
+   LoadGeneratorReport report;
+   std::vector<double> workflowMs, queuedMs, runMs;
+   const auto start = std::chrono::steady_clock::now();
+
+   // Submit, backing off while the service reports it is full
+   auto submit = [&](IGESJobClient& client, const std::string& request) {
+      for (;;) {
+         const std::string reply = client.Request(request);
+         if (reply != "BUSY") return ParseOk(reply, request);
+         {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++report.busyRetries;
+         }
+         std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      }
+   };
+
+   std::vector<std::thread> clients;
+   for (int c = 0; c < options.clients; ++c) {
+      clients.emplace_back([&, c] {
+         try {
+            IGESJobClient client(options.port);
+            std::string reply;
+            while ((reply = client.Request("OPEN")) == "BUSY") std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            const std::string session = std::to_string(ParseOk(reply, "OPEN"));
+
+            for (int w = 0; w < options.workflowsPerClient; ++w) {
+               const std::string resultPath = (fs::path(options.outputDir) / ("loadgen_" + std::to_string(c) + "_" + std::to_string(w) + ".igs")).string();
+               const std::string requests[] = {
+                  "LOAD " + session + " left " + options.partPath,
+                  "ALIGN " + session + " left",
+                  "UNION " + session,
+                  "EXPORT " + session + " fused " + resultPath };
+
+               // A session runs its jobs in order, so the whole workflow is queued up front
+               const auto workflowStart = std::chrono::steady_clock::now();
+               std::vector<int> jobs;
+               for (const std::string& request : requests) jobs.push_back(submit(client, request));
+               bool failed = false;
+               std::vector<std::pair<double, double>> timings;
+               for (int job : jobs) {
+                  reply = client.Request("WAIT " + std::to_string(job));
+                  std::istringstream in(reply);
+                  std::string status;
+                  double queued = 0, run = 0;
+                  in >> status >> queued >> run;
+                  if (status == "DONE") {
+                     timings.emplace_back(queued, run);
+                  }
+                  else if (!failed) {
+                     failed = true;
+                     std::cerr << "Load generator client " << c << ": " << reply << std::endl;
+                  }
+               }
+               const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - workflowStart).count();
+
+               std::lock_guard<std::mutex> lock(mutex);
+               ++report.workflows;
+               report.jobs += static_cast<int>(jobs.size());
+               if (failed) ++report.failed;
+               workflowMs.push_back(ms);
+               for (const auto& [queued, run] : timings) {
+                  queuedMs.push_back(queued);
+                  runMs.push_back(run);
+               }
+            }
+            client.Request("CLOSE " + session);
+         }
+         catch (const std::exception& ex) {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::cerr << "Load generator client " << c << ": " << ex.what() << std::endl;
+         }
+      });
+   }
+   for (std::thread& client : clients) client.join();
+
+   report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   if (report.seconds > 0) {
+      report.jobsPerMinute = report.jobs * 60.0 / report.seconds;
+      report.workflowsPerMinute = report.workflows * 60.0 / report.seconds;
+   }
+   report.medianWorkflowMs = Percentile(workflowMs, 0.5);
+   report.p95WorkflowMs = Percentile(workflowMs, 0.95);
+   auto mean = [](const std::vector<double>& values) {
+      double sum = 0;
+      for (double value : values) sum += value;
+      return values.empty() ? 0.0 : sum / values.size();
+   };
+   report.meanQueuedMs = mean(queuedMs);
+   report.meanRunMs = mean(runMs);
+   return report;
+}
+
+std::string IGESJobService::Format(const LoadGeneratorReport& report)
+{
+   std::ostringstream out;
+   out.setf(std::ios::fixed);
+   out.precision(1);
+   out << report.workflows << " workflows (" << report.failed << " failed), " << report.jobs << " jobs in "
+      << report.seconds << " s: " << report.jobsPerMinute << " jobs/min, " << report.workflowsPerMinute
+      << " workflows/min; workflow median " << report.medianWorkflowMs << " ms, p95 " << report.p95WorkflowMs
+      << " ms; per job queued " << report.meanQueuedMs << " ms, run " << report.meanRunMs << " ms; "
+      << report.busyRetries << " busy retries";
+   return out.str();
+}
+
+IGESJobClient::IGESJobClient(int port)
+{
+   WSADATA data;
+   if (WSAStartup(MAKEWORD(2, 2), &data) != 0) throw std::runtime_error("Winsock initialization failed.");
+   SOCKET client = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+   sockaddr_in address{};
+   address.sin_family = AF_INET;
+   address.sin_port = htons(static_cast<u_short>(port));
+   inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+   if (client == INVALID_SOCKET || connect(client, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+      if (client != INVALID_SOCKET) closesocket(client);
+      WSACleanup();
+      throw std::runtime_error("Cannot connect to the job service on port " + std::to_string(port) + ".");
+   }
+   mSocket = static_cast<std::uintptr_t>(client);
+}
+
+IGESJobClient::~IGESJobClient()
+{
+   closesocket(static_cast<SOCKET>(mSocket));
+   WSACleanup();
+}
+
+std::string IGESJobClient::Request(const std::string& line)
+{
+   const SOCKET client = static_cast<SOCKET>(mSocket);
+   SendLine(client, line);
+   std::string reply;
+   if (!ReadLine(client, mPending, reply)) throw std::runtime_error("The job service closed the connection.");
+   return reply;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Geometry jobs served over a localhost TCP socket. Each client request is one text line
+// and gets one reply line:
+//
+//   OPEN                               -> OK <session>           (BUSY when every worker is taken)
+//   LOAD <session> <slot> <path>       -> OK <job> | BUSY | ERR <message>
+//   ALIGN <session> <slot>             -> (same; slot is left or right)
+//   UNION <session>                    -> (same; unites left with its mirrored copy into fused)
+//   UNIONSLOTS <session> <result> <slot> <slot>...
+//   EXPORT <session> <slot> <path>     -> (same; format from the path extension)
+//   STATUS <job>                       -> PENDING | DONE <queuedMs> <runMs> | FAILED <message>
+//   WAIT <job>                         -> DONE ... | FAILED ..., once the job has finished
+//   CLOSE <session>                    -> OK, after the session's jobs have finished
+//   STATS                              -> OK accepted=.. refused=.. done=.. failed=.. inflight=..
+//   SHUTDOWN <token>                   -> OK, then the server stops
+//
+// A session is one IGESSessionEngine session, so its shapes stay loaded between jobs and a
+// multi-step workflow translates its IGES once. Jobs of one session run in submission
+// order. The IGES and STEP translation of LOAD and EXPORT jobs takes turns across sessions
+// behind the handler's translator lock; alignment and union jobs run side by side. Sessions and jobs belong to the connection that opened or submitted them; when it
+// drops, its sessions are closed and its unreported jobs forgotten. A finished job's result
+// is dropped once DONE or FAILED has been returned for it. Request lines are limited to
+// kMaxRequestLength bytes; a longer one drops the connection.
+struct JobServiceOptions
+{
+   int port = 5757;                // Bound to 127.0.0.1 only
+   std::size_t queueCapacity = 16; // Jobs queued or running at once; further jobs get BUSY
+   int maxSessions = 8;            // One worker thread per session
+   std::string shutdownToken;      // SHUTDOWN must quote it; a random one is printed when empty
+};
+
+constexpr std::size_t kMaxRequestLength = 64 * 1024;
+
+struct LoadGeneratorOptions
+{
+   int port = 5757;
+   std::string partPath;          // Part every workflow loads
+   std::string outputDir;         // Fused results are exported here
+   int clients = 4;               // Connections, each with its own session
+   int workflowsPerClient = 5;    // Load, align, union and export per workflow
+};
+
+struct LoadGeneratorReport
+{
+   int workflows = 0;             // Completed, failed ones included
+   int failed = 0;
+   int jobs = 0;
+   int busyRetries = 0;           // Submissions refused by back-pressure and retried
+   double seconds = 0;
+   double jobsPerMinute = 0;
+   double workflowsPerMinute = 0;
+   double medianWorkflowMs = 0, p95WorkflowMs = 0;
+   double meanQueuedMs = 0, meanRunMs = 0; // Per job, as timed by the server
+};
+
+class IGESJobService
+{
+public:
+   // Serve on the calling thread until a client sends SHUTDOWN with the token
+   static void Serve(const JobServiceOptions& options);
+
+   // Drive a running server with concurrent union workflows and measure its throughput
+   static LoadGeneratorReport RunLoadGenerator(const LoadGeneratorOptions& options);
+
+   static std::string Format(const LoadGeneratorReport& report);
+};
+
+// Blocking client for the line protocol above
+class IGESJobClient
+{
+public:
+   explicit IGESJobClient(int port);
+   ~IGESJobClient();
+
+   IGESJobClient(const IGESJobClient&) = delete;
+   IGESJobClient& operator=(const IGESJobClient&) = delete;
+
+   // Send one request line and return the reply line
+   std::string Request(const std::string& line);
+
+private:
+   std::uintptr_t mSocket; // SOCKET, kept opaque so the header stays free of Winsock
+   std::string mPending;   // Bytes received past the last reply
+};
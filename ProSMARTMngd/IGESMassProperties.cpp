@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <vector>
+#include <omp.h>
+#include <BRepAdaptor_Curve.hxx>
+#include <BRepGProp.hxx>
+#include <BRepGProp_Domain.hxx>
+#include <BRepGProp_Face.hxx>
+#include <BRepGProp_Vinert.hxx>
+#include <BRep_Tool.hxx>
+#include <GCPnts_AbscissaPoint.hxx>
+#include <GProp_GProps.hxx>
+#include <Standard_Failure.hxx>
+#include <TopExp.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Edge.hxx>
+#include <TopoDS_Face.hxx>
+#include <TopoDS_Shape.hxx>
+#include <gp.hxx>
+
+#include "IGESMassProperties.h"
+#include "IGESTrace.h"
+
+namespace
+{
+   // A face as met inside the shape, with the orientation it has there
+   struct FaceItem
+   {
+      TopoDS_Face face;
+      bool bounding = false; // Bounds a solid, so it contributes to the volume
+   };
+
+   // Mass and first moment of one face integral
+   struct Partial
+   {
+      double mass = 0;
+      gp_XYZ moment;
+
+      void Add(const GProp_GProps& props) {
+         mass += props.Mass();
+         moment += props.CentreOfMass().XYZ() * props.Mass();
+      }
+   };
+
+   // Volume of the cone from the global origin to one face. BRepGProp::VolumeProperties
+   // would put the apex at the origin moved by the face's Location, and cones with
+   // different apexes do not sum to the solid's volume.
+   void AddFaceVolume(const TopoDS_Face& face, Partial& volume)
+   {
+      BRepGProp_Face surface(face);
+      BRepGProp_Vinert props;
+      props.SetLocation(gp::Origin());
+      if (surface.NaturalRestriction()) {
+         props.Perform(surface);
+      }
+      else {
+         BRepGProp_Domain domain(face);
+         props.Perform(surface, domain);
+      }
+      volume.Add(props);
+   }
+}
+
+MassPropertiesReport IGESMassProperties::Compute(const TopoDS_Shape& shape, int nThreads)
+{
+   PROSMART_TRACE_SCOPE("MassProperties");
+   MassPropertiesReport report;
+   if (shape.IsNull()) return report;
+   auto start = std::chrono::steady_clock::now();
+
+   // Solid faces first, then the faces of open shells and loose faces
+   std::vector<FaceItem> faces;
+   for (TopExp_Explorer solid(shape, TopAbs_SOLID); solid.More(); solid.Next()) {
+      ++report.nSolids;
+      for (TopExp_Explorer face(solid.Current(), TopAbs_FACE); face.More(); face.Next())
+         faces.push_back({ TopoDS::Face(face.Current()), true });
+   }
+   for (TopExp_Explorer face(shape, TopAbs_FACE, TopAbs_SOLID); face.More(); face.Next())
+      faces.push_back({ TopoDS::Face(face.Current()), false });
+
+   TopTools_IndexedMapOfShape uniqueFaces, edges, vertices;
+   TopExp::MapShapes(shape, TopAbs_FACE, uniqueFaces);
+   TopExp::MapShapes(shape, TopAbs_EDGE, edges);
+   TopExp::MapShapes(shape, TopAbs_VERTEX, vertices);
+   report.nFaces = uniqueFaces.Extent();
+   report.nVertices = vertices.Extent();
+
+   report.nThreads = nThreads > 0 ? nThreads : omp_get_max_threads();
+   const int nFaceItems = static_cast<int>(faces.size());
+   const int nEdgeItems = edges.Extent();
+   std::vector<Partial> volumes(nFaceItems), areas(nFaceItems);
+   std::vector<double> lengths(nEdgeItems, -1.0); // -1 marks degenerated edges
+
+   // Each face and edge is independent; results land in their own slot
+#pragma omp parallel num_threads(report.nThreads)
+   {
+#pragma omp for schedule(dynamic, 4) nowait
+      for (int i = 0; i < nFaceItems; ++i) {
+         try {
+            GProp_GProps surface;
+            BRepGProp::SurfaceProperties(faces[i].face, surface);
+            areas[i].Add(surface);
+            if (faces[i].bounding) {
+               AddFaceVolume(faces[i].face, volumes[i]);
+            }
+         }
+         catch (const Standard_Failure&) {
+            // An unintegrable face contributes nothing
+         }
+      }
+#pragma omp for schedule(dynamic, 16)
+      for (int i = 0; i < nEdgeItems; ++i) {
+         const TopoDS_Edge& edge = TopoDS::Edge(edges(i + 1));
+         if (BRep_Tool::Degenerated(edge)) continue;
+         try {
+            lengths[i] = GCPnts_AbscissaPoint::Length(BRepAdaptor_Curve(edge));
+         }
+         catch (const Standard_Failure&) {
+            lengths[i] = 0;
+         }
+      }
+   }
+
+   // Combine serially in face order
+   Partial volume, area;
+   for (int i = 0; i < nFaceItems; ++i) {
+      volume.mass += volumes[i].mass;
+      volume.moment += volumes[i].moment;
+      area.mass += areas[i].mass;
+      area.moment += areas[i].moment;
+   }
+   report.volume = volume.mass;
+   report.area = area.mass;
+   const Partial& centerSource = std::abs(volume.mass) > 0 ? volume : area;
+   if (std::abs(centerSource.mass) > 0) {
+      const gp_XYZ center = centerSource.moment / centerSource.mass;
+      report.centerX = center.X();
+      report.centerY = center.Y();
+      report.centerZ = center.Z();
+   }
+
+   double minLength = std::numeric_limits<double>::max();
+   double maxLength = 0;
+   for (double length : lengths) {
+      if (length < 0) continue;
+      ++report.nEdges;
+      minLength = std::min(minLength, length);
+      maxLength = std::max(maxLength, length);
+   }
+   if (report.nEdges > 0) {
+      report.minEdgeLength = minLength;
+      report.maxEdgeLength = maxLength;
+   }
+
+   report.valid = true;
+   report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   return report;
+}
+
+std::string IGESMassProperties::Format(const MassPropertiesReport& report)
+{
+   if (!report.valid) return "no shape";
+   char line[512];
+   std::snprintf(line, sizeof(line),
+      "volume %.6g, area %.6g, center (%.4f, %.4f, %.4f), %d solids, %d faces, %d edges, %d vertices, "
+      "edge length %.4g..%.4g, %.1f ms on %d threads",
+      report.volume, report.area, report.centerX, report.centerY, report.centerZ,
+      report.nSolids, report.nFaces, report.nEdges, report.nVertices,
+      report.minEdgeLength, report.maxEdgeLength, report.seconds * 1000.0, report.nThreads);
+   return line;
+}
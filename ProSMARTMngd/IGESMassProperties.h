@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+
+class TopoDS_Shape;
+
+// Mass and size figures of one shape
+struct MassPropertiesReport
+{
+   bool valid = false;        // False for a null shape
+   double volume = 0;         // Enclosed by the solids only; 0 for open shells
+   double area = 0;           // All faces
+   double centerX = 0, centerY = 0, centerZ = 0; // Of the volume, or of the area when there is none
+   int nSolids = 0;
+   int nFaces = 0;
+   int nEdges = 0;            // Distinct, degenerated edges excluded
+   int nVertices = 0;
+   double minEdgeLength = 0;
+   double maxEdgeLength = 0;
+   int nThreads = 1;
+   double seconds = 0;        // Time to compute; 0 when the report came from a cache
+};
+
+// Volume, area and center through BRepGProp. Every face (and every edge length) is
+// integrated on its own, spread across threads, and the partial sums are combined in
+// face order so the result does not depend on the thread count.
+class IGESMassProperties
+{
+public:
+   static MassPropertiesReport Compute(const TopoDS_Shape& shape, int nThreads = 0);
+
+   // One line, for logs
+   static std::string Format(const MassPropertiesReport& report);
+};
@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include "IGESScanner.h"
+#include "MappedFile.h"
+
+namespace
+{
+   const std::size_t kRecordLength = 80;
+   const std::size_t kSectionColumn = 72; // Column 73, zero-based
+   const int kMaxTrackedType = 1000;       // Standard entity types are all below 1000
+
+   enum class EntityClass : unsigned char { Unknown, Geometry, Surface, Solid, Other };
+
+   // Entity types understood by the OCCT IGES translator, by class
+   std::array<EntityClass, kMaxTrackedType> BuildEntityClasses() {
+      std::array<EntityClass, kMaxTrackedType> classes;
+      classes.fill(EntityClass::Unknown);
+      for (int t : { 100, 102, 104, 106, 110, 112, 116, 123, 124, 125, 126, 130, 141, 142, 502, 504, 508, 510, 514 })
+         classes[t] = EntityClass::Geometry;
+      for (int t : { 108, 114, 118, 120, 122, 128, 140, 143, 144, 190, 192, 194, 196, 198 })
+         classes[t] = EntityClass::Surface;
+      for (int t : { 150, 152, 154, 156, 158, 160, 162, 164, 168, 180, 182, 184, 186, 430 })
+         classes[t] = EntityClass::Solid;
+      for (int t : { 0, 132, 134, 136, 138, 146, 148, 202, 204, 206, 208, 210, 212, 213, 214, 216, 218, 220, 222,
+                     228, 230, 302, 304, 306, 308, 310, 312, 314, 316, 320, 322, 402, 404, 406, 408, 410, 412,
+                     414, 416, 418, 420, 422 })
+         classes[t] = EntityClass::Other;
+      return classes;
+   }
+
+   // Right-justified integer field of a fixed-column record; blanks read as zero
+   int ParseField(const char* field, std::size_t width) {
+      int value = 0;
+      bool negative = false;
+      for (std::size_t i = 0; i < width; ++i) {
+         char c = field[i];
+         if (c >= '0' && c <= '9') value = value * 10 + (c - '0');
+         else if (c == '-') negative = true;
+      }
+      return negative ? -value : value;
+   }
+
+   int SectionRank(char letter) {
+      switch (letter) {
+      case 'S': return 0;
+      case 'G': return 1;
+      case 'D': return 2;
+      case 'P': return 3;
+      case 'T': return 4;
+      }
+      return -1;
+   }
+}
+
+IGESScanReport IGESScanner::Scan(const std::string& filePath)
+{
+   MappedFile file(filePath);
+   return Scan(file.Data(), file.Size());
+}
+
+IGESScanReport IGESScanner::Scan(const char* data, std::size_t size)
+{
+   static const std::array<EntityClass, kMaxTrackedType> entityClasses = BuildEntityClasses();
+
+   IGESScanReport report;
+   report.fileSize = size;
+   if (size == 0) {
+      report.error = "The file is empty.";
+      return report;
+   }
+
+   // Records are normally newline-terminated, but some writers emit bare 80-byte records
+   const bool fixedRecords = size >= kRecordLength && std::memchr(data, '\n', std::min(size, kRecordLength + 4)) == nullptr;
+
+   std::array<int, kMaxTrackedType> counts{};
+   IGESSectionIndex* sections[] = { &report.start, &report.global, &report.directory, &report.parameter, &report.terminate };
+   int currentRank = -1;
+   int lineNumber = 0;
+   int nGeometry = 0;
+   const char* end = data + size;
+
+   for (const char* line = data; line < end;) {
+      const char* next;
+      std::size_t length;
+      if (fixedRecords) {
+         length = std::min<std::size_t>(kRecordLength, end - line);
+         next = line + length;
+      }
+      else {
+         const char* newline = static_cast<const char*>(std::memchr(line, '\n', end - line));
+         next = newline ? newline + 1 : end;
+         length = (newline ? newline : end) - line;
+         if (length > 0 && line[length - 1] == '\r') --length;
+      }
+      ++lineNumber;
+
+      if (length == 0) { // Tolerate blank lines, typically a trailing newline
+         line = next;
+         continue;
+      }
+      if (length <= kSectionColumn) {
+         report.error = "Line " + std::to_string(lineNumber) + " is not a fixed-column IGES record.";
+         return report;
+      }
+
+      const char letter = line[kSectionColumn];
+      if (lineNumber == 1 && (letter == 'C' || letter == 'B')) {
+         report.error = letter == 'C' ? "Compressed ASCII IGES is not supported." : "Binary IGES is not supported.";
+         return report;
+      }
+
+      const int rank = SectionRank(letter);
+      if (rank < 0 || rank < currentRank) {
+         report.error = "Unexpected section code '" + std::string(1, letter) + "' on line " + std::to_string(lineNumber) + ".";
+         return report;
+      }
+      IGESSectionIndex& section = *sections[rank];
+      if (rank != currentRank) {
+         section.offset = line - data;
+         currentRank = rank;
+      }
+      section.length = next - data - section.offset;
+      ++section.lines;
+
+      // First line of each two-line directory entry: type in columns 1-8, status in 65-72
+      if (letter == 'D' && (section.lines % 2) == 1) {
+         const int type = ParseField(line, 8);
+         const bool independent = length >= 68 && ParseField(line + 66, 2) == 0;
+         EntityClass entityClass = EntityClass::Unknown;
+         if (type >= 0 && type < kMaxTrackedType) {
+            ++counts[type];
+            entityClass = entityClasses[type];
+         }
+         switch (entityClass) {
+         case EntityClass::Unknown: ++report.nUnknownEntities; break;
+         case EntityClass::Surface: ++nGeometry; if (independent) ++report.nSurfaceEntities; break;
+         case EntityClass::Solid: ++nGeometry; if (independent) ++report.nSolidEntities; break;
+         case EntityClass::Geometry: ++nGeometry; break;
+         case EntityClass::Other: break;
+         }
+      }
+      line = next;
+   }
+
+   report.nEntities = report.directory.lines / 2;
+   for (int type = 0; type < kMaxTrackedType; ++type) {
+      if (counts[type] > 0) report.entityCounts.emplace_back(type, counts[type]);
+   }
+
+   if (report.global.lines == 0 || report.directory.lines == 0 || report.parameter.lines == 0) {
+      report.error = "The Global, Directory or Parameter section is missing.";
+      return report;
+   }
+   if (report.directory.lines % 2 != 0) {
+      report.error = "The Directory section has an odd number of lines.";
+      return report;
+   }
+   if (nGeometry == 0) {
+      report.error = "The file contains no geometry that can be translated.";
+      return report;
+   }
+
+   // Heuristic from typical parts: the parsed model takes a few times the parameter
+   // text plus a fixed overhead per entity
+   report.estimatedModelBytes = report.parameter.length * 4 + static_cast<std::size_t>(report.nEntities) * 512;
+   report.supported = true;
+   return report;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Byte range of one IGES section within the file
+struct IGESSectionIndex
+{
+   std::size_t offset = 0;
+   std::size_t length = 0;
+   int lines = 0;
+};
+
+// Result of a pre-pass over the fixed-column IGES text
+struct IGESScanReport
+{
+   bool supported = false;
+   std::string error;                 // Why the file was rejected, if it was
+
+   std::size_t fileSize = 0;
+   IGESSectionIndex start, global, directory, parameter, terminate;
+
+   int nEntities = 0;                 // Directory entries (two D lines each)
+   int nSurfaceEntities = 0;          // Independent surfaces: trimmed, bounded, analytic and spline surfaces
+   int nSolidEntities = 0;            // MSBO and CSG solids
+   int nUnknownEntities = 0;          // Entity types the IGES translator does not know
+   std::vector<std::pair<int, int>> entityCounts; // (entity type, count), sorted by type
+
+   std::size_t estimatedModelBytes = 0; // Rough memory the parsed model will need
+};
+
+// Linear scan of an IGES file that indexes its sections and counts entities by type
+// without parsing parameters or allocating per line
+class IGESScanner
+{
+public:
+   // Memory-map the file and scan it
+   static IGESScanReport Scan(const std::string& filePath);
+
+   // Scan IGES text already in memory
+   static IGESScanReport Scan(const char* data, std::size_t size);
+};
@@ -0,0 +1,182 @@
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "IGESSessionEngine.h"
+#include "IGESHandler.h"
+#include "IGESTrace.h"
+
+class IGESSessionJob_PIMPL
+{
+public:
+   std::shared_future<SessionJobTimings> mResult;
+};
+
+bool IGESSessionJob::IsReady() const
+{
+   if (!mpPimpl) return false;
+   return mpPimpl->mResult.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+void IGESSessionJob::Wait() const
+{
+   if (!mpPimpl) throw std::runtime_error("No session job was submitted.");
+   mpPimpl->mResult.wait();
+}
+
+SessionJobTimings IGESSessionJob::Get() const
+{
+   if (!mpPimpl) throw std::runtime_error("No session job was submitted.");
+   return mpPimpl->mResult.get();
+}
+
+namespace
+{
+   // One session: a FIFO of jobs drained by the thread that owns the handler
+   class Session
+   {
+   public:
+      Session() : mWorker([this] { Run(); }) {}
+
+      ~Session() {
+         {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mClosing = true;
+         }
+         mWake.notify_one();
+         mWorker.join();
+      }
+
+      std::shared_future<SessionJobTimings> Push(std::function<void(IGESHandler&)> work) {
+         const auto submitted = std::chrono::steady_clock::now();
+         std::packaged_task<SessionJobTimings(IGESHandler&)> task([work = std::move(work), submitted](IGESHandler& handler) {
+            const auto started = std::chrono::steady_clock::now();
+            work(handler);
+            SessionJobTimings timings;
+            timings.queuedSeconds = std::chrono::duration<double>(started - submitted).count();
+            timings.runSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+            return timings;
+         });
+         std::shared_future<SessionJobTimings> result = task.get_future().share();
+         {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mClosing) throw std::runtime_error("The session is closing.");
+            mJobs.push_back(std::move(task));
+         }
+         mWake.notify_one();
+         return result;
+      }
+
+      bool IsWorkerThread() const {
+         return std::this_thread::get_id() == mWorker.get_id();
+      }
+
+   private:
+      void Run() {
+         // Created here so every OCCT object of the session lives on this thread
+         IGESHandler handler;
+         for (;;) {
+            std::packaged_task<SessionJobTimings(IGESHandler&)> task;
+            {
+               std::unique_lock<std::mutex> lock(mMutex);
+               mWake.wait(lock, [this] { return mClosing || !mJobs.empty(); });
+               if (mJobs.empty()) return; // Closing and drained
+               task = std::move(mJobs.front());
+               mJobs.pop_front();
+            }
+            PROSMART_TRACE_SCOPE("SessionJob");
+            task(handler); // A failing job stores its exception in the future
+         }
+      }
+
+      std::mutex mMutex;
+      std::condition_variable mWake;
+      std::deque<std::packaged_task<SessionJobTimings(IGESHandler&)>> mJobs;
+      bool mClosing = false;
+      std::thread mWorker; // Last, so the queue exists before the thread starts
+   };
+}
+
+class IGESSessionEngine_PIMPL
+{
+public:
+   mutable std::mutex mMutex;
+   std::map<int, std::shared_ptr<Session>> mSessions;
+   int mNextSession = 1;
+
+   std::shared_ptr<Session> Find(int session) const {
+      std::lock_guard<std::mutex> lock(mMutex);
+      auto it = mSessions.find(session);
+      if (it == mSessions.end()) throw std::runtime_error("No session " + std::to_string(session) + " is open.");
+      return it->second;
+   }
+};
+
+IGESSessionEngine::IGESSessionEngine() : mpPimpl(std::make_unique<IGESSessionEngine_PIMPL>())
+{
+   IGESHandler::InitTranslators(); // Before any session thread starts
+}
+
+IGESSessionEngine::~IGESSessionEngine()
+{
+   std::map<int, std::shared_ptr<Session>> sessions;
+   {
+      std::lock_guard<std::mutex> lock(mpPimpl->mMutex);
+      sessions.swap(mpPimpl->mSessions);
+   }
+   sessions.clear(); // Joins the workers outside the lock
+}
+
+int IGESSessionEngine::OpenSession()
+{
+   auto session = std::make_shared<Session>();
+   std::lock_guard<std::mutex> lock(mpPimpl->mMutex);
+   const int id = mpPimpl->mNextSession++;
+   mpPimpl->mSessions.emplace(id, std::move(session));
+   return id;
+}
+
+void IGESSessionEngine::CloseSession(int session)
+{
+   std::shared_ptr<Session> closing;
+   {
+      std::lock_guard<std::mutex> lock(mpPimpl->mMutex);
+      auto it = mpPimpl->mSessions.find(session);
+      if (it == mpPimpl->mSessions.end()) return;
+      if (it->second->IsWorkerThread()) {
+         throw std::runtime_error("Session " + std::to_string(session) + " cannot be closed from one of its own jobs.");
+      }
+      closing = std::move(it->second);
+      mpPimpl->mSessions.erase(it);
+   }
+   closing.reset(); // Joins the worker outside the lock
+}
+
+int IGESSessionEngine::SessionCount() const
+{
+   std::lock_guard<std::mutex> lock(mpPimpl->mMutex);
+   return static_cast<int>(mpPimpl->mSessions.size());
+}
+
+IGESSessionJob IGESSessionEngine::Submit(int session, std::function<void(IGESHandler&)> work)
+{
+   IGESSessionJob job;
+   job.mpPimpl = std::make_shared<IGESSessionJob_PIMPL>();
+   job.mpPimpl->mResult = mpPimpl->Find(session)->Push(std::move(work));
+   return job;
+}
+
+IGESSessionJob IGESSessionEngine::SubmitUnion(int session, const std::string& partPath, const std::string& resultPath)
+{
+   return Submit(session, [partPath, resultPath](IGESHandler& handler) {
+      handler.LoadShape(partPath, 0);
+      handler.AlignToXYPlane(0);
+      handler.UnionShapes();
+      handler.SaveShape(resultPath, 2);
+   });
+}
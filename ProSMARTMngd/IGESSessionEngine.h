@@ -0,0 +1,72 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <string>
+
+class IGESHandler;
+class IGESSessionEngine_PIMPL;
+class IGESSessionJob_PIMPL;
+
+// Where the time of one session job went
+struct SessionJobTimings
+{
+   double queuedSeconds = 0; // From Submit until the session's worker picked the job up
+   double runSeconds = 0;
+};
+
+// Handle to work queued on a session; copies share the same result. The header stays free
+// of <future> so the /clr wrapper can include it.
+class IGESSessionJob
+{
+public:
+   IGESSessionJob() = default;
+
+   bool IsValid() const { return mpPimpl != nullptr; }
+   bool IsReady() const;
+   void Wait() const;
+
+   // Block until the job finishes; rethrows the exception the job failed with
+   SessionJobTimings Get() const;
+
+private:
+   friend class IGESSessionEngine;
+   std::shared_ptr<IGESSessionJob_PIMPL> mpPimpl;
+};
+
+// Hosts many independent IGESHandler sessions in one process. Every session owns one
+// worker thread, and its handler is created, used and destroyed only on that thread, so
+// sessions share no handler state. They do share what is global to the process: the
+// Interface_Static translator parameters and XSControl sessions, and the IGESTrace buffer
+// and switch. The engine registers the translators before any session starts, and the IGES
+// and STEP readers and writers take one lock around them. A union keeps the Boolean's
+// intersection data and the fuse built on it in the handler's arena rather than on the
+// global heap; escalated candidates and the speculative union each use an arena of their own.
+class IGESSessionEngine
+{
+public:
+   IGESSessionEngine();
+
+   // Closes every session, finishing the work already queued
+   ~IGESSessionEngine();
+
+   IGESSessionEngine(const IGESSessionEngine&) = delete;
+   IGESSessionEngine& operator=(const IGESSessionEngine&) = delete;
+
+   // Start a session and its worker thread; returns the session id
+   int OpenSession();
+
+   // Finish the session's queued jobs, then stop its worker and release its handler.
+   // Throws when called from one of the session's own jobs, which would wait for itself.
+   void CloseSession(int session);
+
+   int SessionCount() const;
+
+   // Run work on the session's worker thread, after the jobs queued before it
+   IGESSessionJob Submit(int session, std::function<void(IGESHandler&)> work);
+
+   // Load a part, align it, unite it with its mirrored copy and save the result
+   IGESSessionJob SubmitUnion(int session, const std::string& partPath, const std::string& resultPath);
+
+private:
+   std::unique_ptr<IGESSessionEngine_PIMPL> mpPimpl;
+};
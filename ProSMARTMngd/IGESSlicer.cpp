@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <map>
+#include <stdexcept>
+#include <omp.h>
+#include <BRepAdaptor_Curve.hxx>
+#include <BRepAlgoAPI_Section.hxx>
+#include <BRepBndLib.hxx>
+#include <BRepBuilderAPI_Copy.hxx>
+#include <BRepMesh_IncrementalMesh.hxx>
+#include <BRepTools_WireExplorer.hxx>
+#include <BRep_Builder.hxx>
+#include <BRep_Tool.hxx>
+#include <Bnd_Box.hxx>
+#include <GCPnts_QuasiUniformDeflection.hxx>
+#include <Poly_Triangulation.hxx>
+#include <ShapeAnalysis_FreeBounds.hxx>
+#include <Standard_Failure.hxx>
+#include <TopExp.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopTools_HSequenceOfShape.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Compound.hxx>
+#include <TopoDS_Edge.hxx>
+#include <TopoDS_Face.hxx>
+#include <TopoDS_Wire.hxx>
+#include <gp_Pln.hxx>
+
+#include "FaceBoxIndex.h"
+#include "IGESSlicer.h"
+#include "IGESTrace.h"
+
+namespace
+{
+   std::array<double, 3> ToArray(const gp_XYZ& p) {
+      return { p.X(), p.Y(), p.Z() };
+   }
+
+   // Sample a connected wire edge by edge, following the wire direction
+   SlicePolyline WireToPolyline(const TopoDS_Wire& wire, double deflection) {
+      SlicePolyline polyline;
+      for (BRepTools_WireExplorer explorer(wire); explorer.More(); explorer.Next()) {
+         const TopoDS_Edge& edge = explorer.Current();
+         std::vector<gp_XYZ> points;
+         BRepAdaptor_Curve curve(edge);
+         GCPnts_QuasiUniformDeflection sampler(curve, deflection);
+         if (sampler.IsDone() && sampler.NbPoints() >= 2) {
+            for (int i = 1; i <= sampler.NbPoints(); ++i) points.push_back(sampler.Value(i).XYZ());
+         }
+         else {
+            points.push_back(curve.Value(curve.FirstParameter()).XYZ());
+            points.push_back(curve.Value(curve.LastParameter()).XYZ());
+         }
+         if (edge.Orientation() == TopAbs_REVERSED) std::reverse(points.begin(), points.end());
+
+         // Consecutive edges share their vertex
+         for (std::size_t i = polyline.points.empty() ? 0 : 1; i < points.size(); ++i)
+            polyline.points.push_back(ToArray(points[i]));
+      }
+      polyline.closed = wire.Closed() || BRep_Tool::IsClosed(wire);
+      if (polyline.closed && polyline.points.size() > 2) polyline.points.pop_back(); // Repeats the first point
+      return polyline;
+   }
+
+   // Exact section of the candidate faces; the faces are shared between stations, so the
+   // Boolean must leave them untouched
+   void SectionExact(const FaceBoxIndex& index, const std::vector<int>& faces, const gp_Pln& plane,
+      double deflection, double tolerance, SliceResult& result) {
+      TopoDS_Compound compound;
+      BRep_Builder builder;
+      builder.MakeCompound(compound);
+      for (int face : faces) builder.Add(compound, index.Faces()(face));
+
+      BRepAlgoAPI_Section section(compound, plane, Standard_False);
+      section.SetNonDestructive(Standard_True);
+      section.SetRunParallel(Standard_False); // Stations are already spread across the cores
+      section.ComputePCurveOn1(Standard_False);
+      section.Approximation(Standard_False);
+      section.Build();
+      if (!section.IsDone()) throw std::runtime_error("Section failed.");
+
+      Handle(TopTools_HSequenceOfShape) edges = new TopTools_HSequenceOfShape();
+      for (TopExp_Explorer explorer(section.Shape(), TopAbs_EDGE); explorer.More(); explorer.Next())
+         edges->Append(explorer.Current());
+      if (edges->IsEmpty()) return;
+
+      Handle(TopTools_HSequenceOfShape) wires;
+      ShapeAnalysis_FreeBounds::ConnectEdgesToWires(edges, tolerance, Standard_False, wires);
+      for (int i = 1; i <= wires->Length(); ++i)
+         result.polylines.push_back(WireToPolyline(TopoDS::Wire(wires->Value(i)), deflection));
+   }
+
+   // Point where a mesh edge crosses the plane. The ends are put in a fixed order first, so
+   // the two triangles sharing the edge produce the same point bit for bit.
+   gp_XYZ EdgeCrossing(gp_XYZ a, gp_XYZ b, int axis, double value) {
+      if (b.X() < a.X() || (b.X() == a.X() && (b.Y() < a.Y() || (b.Y() == a.Y() && b.Z() < a.Z())))) std::swap(a, b);
+      if (a.Coord(axis) == value) return a; // Nodes on the plane are used as they are
+      if (b.Coord(axis) == value) return b;
+      const double t = (value - a.Coord(axis)) / (b.Coord(axis) - a.Coord(axis));
+      gp_XYZ point = a + (b - a) * t;
+      point.SetCoord(axis, value);
+      return point;
+   }
+
+   // Join segments that share end points into polylines
+   std::vector<SlicePolyline> ChainSegments(const std::vector<std::pair<gp_XYZ, gp_XYZ>>& segments, double quantum) {
+      using Key = std::array<long long, 3>;
+      auto key = [quantum](const gp_XYZ& p) {
+         return Key{ std::llround(p.X() / quantum), std::llround(p.Y() / quantum), std::llround(p.Z() / quantum) };
+      };
+      std::map<Key, std::vector<int>> ends; // Key -> 2 * segment + end
+      for (int i = 0; i < static_cast<int>(segments.size()); ++i) {
+         ends[key(segments[i].first)].push_back(2 * i);
+         ends[key(segments[i].second)].push_back(2 * i + 1);
+      }
+
+      std::vector<bool> used(segments.size(), false);
+      auto next = [&](const gp_XYZ& end, gp_XYZ& other) {
+         for (int id : ends[key(end)]) {
+            const int segment = id / 2;
+            if (used[segment]) continue;
+            used[segment] = true;
+            other = (id % 2) == 0 ? segments[segment].second : segments[segment].first;
+            return true;
+         }
+         return false;
+      };
+
+      std::vector<SlicePolyline> polylines;
+      for (int i = 0; i < static_cast<int>(segments.size()); ++i) {
+         if (used[i]) continue;
+         used[i] = true;
+         std::deque<gp_XYZ> chain = { segments[i].first, segments[i].second };
+         gp_XYZ point;
+         while (next(chain.back(), point)) chain.push_back(point);
+         while (next(chain.front(), point)) chain.push_front(point);
+
+         SlicePolyline polyline;
+         polyline.closed = chain.size() > 3 && key(chain.front()) == key(chain.back());
+         if (polyline.closed) chain.pop_back();
+         for (const gp_XYZ& p : chain) polyline.points.push_back(ToArray(p));
+         polylines.push_back(std::move(polyline));
+      }
+      return polylines;
+   }
+
+   // Section of the candidate faces' triangulations
+   // meshedFaces holds the meshed faces under the index's face numbers
+   void SectionMesh(const TopTools_IndexedMapOfShape& meshedFaces, const std::vector<int>& faces, int axis, double value,
+      double quantum, SliceResult& result) {
+      std::vector<std::pair<gp_XYZ, gp_XYZ>> segments;
+      for (int faceIndex : faces) {
+         const TopoDS_Face& face = TopoDS::Face(meshedFaces(faceIndex));
+         TopLoc_Location location;
+         Handle(Poly_Triangulation) mesh = BRep_Tool::Triangulation(face, location);
+         if (mesh.IsNull()) continue;
+         const gp_Trsf& trsf = location.Transformation();
+         for (int i = 1; i <= mesh->NbTriangles(); ++i) {
+            int n[3];
+            mesh->Triangle(i).Get(n[0], n[1], n[2]);
+            gp_XYZ p[3];
+            bool above[3];
+            for (int k = 0; k < 3; ++k) {
+               p[k] = mesh->Node(n[k]).Transformed(trsf).XYZ();
+               above[k] = p[k].Coord(axis) >= value; // Nodes on the plane count as above
+            }
+            gp_XYZ crossings[2];
+            int nCrossings = 0;
+            for (int k = 0; k < 3; ++k) {
+               const int k1 = (k + 1) % 3;
+               if (above[k] != above[k1]) crossings[nCrossings++] = EdgeCrossing(p[k], p[k1], axis, value);
+            }
+            // Two crossings at one node on the plane touch it without cutting through
+            if (nCrossings == 2 && !crossings[0].IsEqual(crossings[1], 0.0)) segments.emplace_back(crossings[0], crossings[1]);
+         }
+      }
+      result.polylines = ChainSegments(segments, quantum);
+   }
+}
+
+SliceReport IGESSlicer::Slice(const TopoDS_Shape& shape, const SliceOptions& options, const FaceBoxIndex* index)
+{
+   PROSMART_TRACE_SCOPE("Slice");
+   if (shape.IsNull()) throw std::runtime_error("Cannot slice an empty shape.");
+   auto start = std::chrono::steady_clock::now();
+
+   FaceBoxIndex localIndex;
+   if (index == nullptr) {
+      localIndex.Build(shape);
+      index = &localIndex;
+   }
+
+   Bnd_Box box;
+   BRepBndLib::Add(shape, box);
+   const double diagonal = box.IsVoid() ? 1.0 : std::sqrt(box.SquareExtent());
+   const double deflection = options.relativeDeflection * diagonal;
+   const double tolerance = 1e-5 * diagonal; // Joins section edges and mesh segments
+   const int axis = static_cast<int>(options.axis) + 1;
+   const gp_Dir normal(axis == 1 ? 1 : 0, axis == 2 ? 1 : 0, axis == 3 ? 1 : 0);
+
+   TopTools_IndexedMapOfShape meshedFaces;
+   if (options.fast) {
+      // Mesh a copy so the stored triangulations of the part are left alone; an existing
+      // mesh fine enough is copied and kept. The copy keeps the face order, so the
+      // index's face numbers address its faces too.
+      PROSMART_TRACE_SCOPE("Slice/Mesh");
+      const TopoDS_Shape copy = BRepBuilderAPI_Copy(shape, Standard_True, Standard_True).Shape();
+      BRepMesh_IncrementalMesh mesher(copy, deflection, Standard_False, 0.5, Standard_True);
+      TopExp::MapShapes(copy, TopAbs_FACE, meshedFaces);
+      if (meshedFaces.Extent() != index->Faces().Extent()) throw std::runtime_error("The face index does not belong to the shape.");
+   }
+
+   SliceReport report;
+   report.nThreads = options.nThreads > 0 ? options.nThreads : omp_get_max_threads();
+   const int nStations = static_cast<int>(options.stations.size());
+   report.slices.resize(nStations);
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(report.nThreads)
+   for (int i = 0; i < nStations; ++i) {
+      SliceResult& result = report.slices[i];
+      result.station = options.stations[i];
+      try {
+         const std::vector<int> faces = index->FacesCrossing(axis, result.station);
+         result.nFaces = static_cast<int>(faces.size());
+         if (faces.empty()) continue;
+         if (options.fast) {
+            SectionMesh(meshedFaces, faces, axis, result.station, tolerance, result);
+         }
+         else {
+            gp_Pnt origin(0, 0, 0);
+            origin.SetCoord(axis, result.station);
+            SectionExact(*index, faces, gp_Pln(origin, normal), deflection, tolerance, result);
+         }
+      }
+      catch (const Standard_Failure& failure) {
+         result.error = failure.GetMessageString() != nullptr ? failure.GetMessageString() : "Section failed.";
+      }
+      catch (const std::exception& ex) {
+         result.error = ex.what();
+      }
+   }
+
+   report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   return report;
+}
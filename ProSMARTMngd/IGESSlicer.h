@@ -0,0 +1,54 @@
+#pragma once
+#include <array>
+#include <string>
+#include <vector>
+
+class TopoDS_Shape;
+class FaceBoxIndex;
+
+enum class SliceAxis
+{
+   X,
+   Y,
+   Z
+};
+
+struct SliceOptions
+{
+   SliceAxis axis = SliceAxis::X;
+   std::vector<double> stations;     // Plane positions along the axis
+   bool fast = false;                // Intersect the triangulation instead of the exact surfaces
+   double relativeDeflection = 1e-3; // Polyline (and, in fast mode, mesh) deflection as a fraction of the part diagonal
+   int nThreads = 0;                 // 0 = all cores
+};
+
+struct SlicePolyline
+{
+   bool closed = false;                         // The last point joins the first
+   std::vector<std::array<double, 3>> points;
+};
+
+struct SliceResult
+{
+   double station = 0;
+   std::vector<SlicePolyline> polylines;
+   int nFaces = 0;    // Faces whose box reached the plane
+   std::string error; // Set when the section failed; the other stations are unaffected
+};
+
+struct SliceReport
+{
+   std::vector<SliceResult> slices; // In the order of the stations
+   int nThreads = 1;
+   double seconds = 0;
+};
+
+// Cross sections of a shape at many parallel planes, one station per task. Faces are
+// picked per plane from a face bounding-box index, so each section only sees the faces
+// that can cross it.
+class IGESSlicer
+{
+public:
+   // index must have been built on shape; pass nullptr to build one for this call
+   static SliceReport Slice(const TopoDS_Shape& shape, const SliceOptions& options, const FaceBoxIndex* index = nullptr);
+};
@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <AIS_InteractiveContext.hxx>
+#include <AIS_Shape.hxx>
+#include <Aspect_DisplayConnection.hxx>
+#include <Aspect_NeutralWindow.hxx>
+#include <BRepBndLib.hxx>
+#include <BRepMesh_IncrementalMesh.hxx>
+#include <Bnd_Box.hxx>
+#include <IFSelect_ReturnStatus.hxx>
+#include <IGESControl_Reader.hxx>
+#include <Image_AlienPixMap.hxx>
+#include <OpenGl_GraphicDriver.hxx>
+#include <Prs3d_Drawer.hxx>
+#include <STEPControl_Reader.hxx>
+#include <Standard_Failure.hxx>
+#include <TopoDS_Shape.hxx>
+#include <V3d_View.hxx>
+#include <V3d_Viewer.hxx>
+
+#include "IGESThumbnails.h"
+#include "IGESHandler.h"
+#include "IGESTrace.h"
+
+namespace
+{
+   // A part moving through the pipeline; a failed stage fills error and passes it on
+   struct ThumbnailJob
+   {
+      std::filesystem::path source;
+      TopoDS_Shape shape;
+      std::string error;
+   };
+
+   // Blocking FIFO with a fixed capacity: producers wait when it is full, so a fast stage
+   // cannot run ahead of a slow one and hold the whole library in memory
+   class BoundedQueue
+   {
+   public:
+      explicit BoundedQueue(std::size_t capacity) : mCapacity(std::max<std::size_t>(1, capacity)) {}
+
+      void Push(ThumbnailJob job) {
+         std::unique_lock<std::mutex> lock(mMutex);
+         mNotFull.wait(lock, [this] { return mItems.size() < mCapacity; });
+         mItems.push_back(std::move(job));
+         mNotEmpty.notify_one();
+      }
+
+      // Empty once the queue is closed and drained
+      std::optional<ThumbnailJob> Pop() {
+         std::unique_lock<std::mutex> lock(mMutex);
+         mNotEmpty.wait(lock, [this] { return !mItems.empty() || mProducers == 0; });
+         if (mItems.empty()) return std::nullopt;
+         ThumbnailJob job = std::move(mItems.front());
+         mItems.pop_front();
+         mNotFull.notify_one();
+         return job;
+      }
+
+      void AddProducers(int count) {
+         std::lock_guard<std::mutex> lock(mMutex);
+         mProducers += count;
+      }
+
+      // Each producer calls this once when it has pushed its last job
+      void ProducerDone() {
+         std::lock_guard<std::mutex> lock(mMutex);
+         if (--mProducers == 0) mNotEmpty.notify_all();
+      }
+
+   private:
+      std::mutex mMutex;
+      std::condition_variable mNotFull, mNotEmpty;
+      std::deque<ThumbnailJob> mItems;
+      std::size_t mCapacity;
+      int mProducers = 0;
+   };
+
+   std::vector<std::filesystem::path> FindParts(const std::string& inputDir) {
+      std::vector<std::filesystem::path> parts;
+      for (const auto& entry : std::filesystem::recursive_directory_iterator(inputDir)) {
+         if (!entry.is_regular_file()) continue;
+         ShapeFormat format = IGESHandler::DetectFormat(entry.path().string());
+         if (format == ShapeFormat::IGES || format == ShapeFormat::STEP) parts.push_back(entry.path());
+      }
+      std::sort(parts.begin(), parts.end());
+      return parts;
+   }
+
+   TopoDS_Shape ReadPart(const std::filesystem::path& source) {
+      const std::string path = source.string();
+      if (IGESHandler::DetectFormat(path) == ShapeFormat::STEP) {
+         STEPControl_Reader reader;
+         if (reader.ReadFile(path.c_str()) != IFSelect_RetDone) throw std::runtime_error("Failed to read STEP file");
+         reader.TransferRoots();
+         return reader.OneShape();
+      }
+      IGESControl_Reader reader;
+      if (reader.ReadFile(path.c_str()) != IFSelect_RetDone) throw std::runtime_error("Failed to read IGES file");
+      reader.TransferRoots();
+      return reader.OneShape();
+   }
+
+   // Image name for a part. The stem keeps it readable; the key tells apart parts of the same
+   // name in different folders, and changes when the part is modified.
+   std::string ThumbnailName(const std::filesystem::path& source) {
+      std::error_code error;
+      std::filesystem::path full = std::filesystem::weakly_canonical(source, error);
+      if (error) full = std::filesystem::absolute(source);
+      const auto modified = std::filesystem::last_write_time(source, error);
+      const std::string key = full.generic_string() + "|" + std::to_string(error ? 0 : modified.time_since_epoch().count());
+
+      // 64-bit FNV-1a
+      std::uint64_t hash = 14695981039346656037ull;
+      for (unsigned char c : key) {
+         hash ^= c;
+         hash *= 1099511628211ull;
+      }
+      char hex[17];
+      std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+      return source.stem().string() + "_" + hex;
+   }
+
+   std::string Describe(const ThumbnailJob& job) {
+      return job.source.filename().string() + ": " + job.error;
+   }
+}
+
+ThumbnailStats IGESThumbnails::Run(const ThumbnailOptions& options)
+{
+   PROSMART_TRACE_SCOPE("Thumbnails");
+   auto start = std::chrono::steady_clock::now();
+   std::filesystem::create_directories(options.outputDir);
+   const std::vector<std::filesystem::path> parts = FindParts(options.inputDir);
+
+   ThumbnailStats stats;
+   stats.nParts = static_cast<int>(parts.size());
+   int meshThreads = options.meshThreads;
+   if (meshThreads <= 0) meshThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 2);
+
+   // Before the threads start
+   IGESHandler::InitTranslators();
+
+   BoundedQueue loaded(options.queueCapacity), meshed(options.queueCapacity);
+   loaded.AddProducers(1);
+   meshed.AddProducers(meshThreads);
+
+   // Stage 1: read and translate the parts in library order
+   std::thread loader([&]() {
+      for (const auto& source : parts) {
+         PROSMART_TRACE_SCOPE("Thumbnails/Load");
+         ThumbnailJob job;
+         job.source = source;
+         try {
+            job.shape = ReadPart(source);
+            if (job.shape.IsNull()) job.error = "no shapes could be translated";
+         }
+         catch (const Standard_Failure& failure) {
+            job.error = failure.GetMessageString();
+         }
+         catch (const std::exception& ex) {
+            job.error = ex.what();
+         }
+         loaded.Push(std::move(job));
+      }
+      loaded.ProducerDone();
+   });
+
+   // Stage 2: tessellate once at a deflection scaled to the part, so the renderer never meshes
+   std::vector<std::thread> meshers;
+   for (int i = 0; i < meshThreads; ++i) {
+      meshers.emplace_back([&]() {
+         while (std::optional<ThumbnailJob> job = loaded.Pop()) {
+            if (job->error.empty()) {
+               PROSMART_TRACE_SCOPE("Thumbnails/Mesh");
+               try {
+                  Bnd_Box box;
+                  BRepBndLib::Add(job->shape, box);
+                  const double deflection = std::sqrt(box.SquareExtent()) * options.relativeDeflection;
+                  BRepMesh_IncrementalMesh mesher(job->shape, deflection, Standard_False, 0.5, Standard_False);
+               }
+               catch (const Standard_Failure& failure) {
+                  job->error = failure.GetMessageString();
+               }
+               catch (const std::exception& ex) {
+                  job->error = ex.what();
+               }
+            }
+            meshed.Push(std::move(*job));
+         }
+         meshed.ProducerDone();
+      });
+   }
+
+   // Stage 3: render on this thread with one viewer, view and pixmap for the whole batch
+   try {
+      Handle(Aspect_DisplayConnection) displayConnection = new Aspect_DisplayConnection();
+      Handle(OpenGl_GraphicDriver) graphicDriver = new OpenGl_GraphicDriver(displayConnection);
+      Handle(V3d_Viewer) viewer = new V3d_Viewer(graphicDriver);
+      viewer->SetDefaultLights();
+      viewer->SetLightOn();
+      Handle(AIS_InteractiveContext) context = new AIS_InteractiveContext(viewer);
+      Handle(Aspect_NeutralWindow) window = new Aspect_NeutralWindow();
+      window->SetSize(options.width, options.height);
+      window->SetVirtual(true);
+      Handle(V3d_View) view = viewer->CreateView();
+      view->SetImmediateUpdate(Standard_False);
+      view->SetWindow(window);
+      view->SetBackgroundColor(Quantity_Color(Quantity_NOC_WHITE));
+      view->SetProj(V3d_XposYnegZpos);
+      Image_AlienPixMap image;
+
+      while (std::optional<ThumbnailJob> job = meshed.Pop()) {
+         if (!job->error.empty()) {
+            stats.failures.push_back(Describe(*job));
+            continue;
+         }
+         PROSMART_TRACE_SCOPE("Thumbnails/Render");
+         try {
+            context->RemoveAll(Standard_False);
+            Handle(AIS_Shape) presentation = new AIS_Shape(job->shape);
+            presentation->Attributes()->SetAutoTriangulation(Standard_False);
+            context->Display(presentation, AIS_Shaded, 0, Standard_False);
+            view->FitAll(0.05, Standard_False);
+            if (!view->ToPixMap(image, options.width, options.height)) {
+               throw std::runtime_error("failed to render the view to pixmap");
+            }
+
+            std::filesystem::path target = std::filesystem::path(options.outputDir) / ThumbnailName(job->source);
+            target += "." + options.imageExtension;
+            if (!image.Save(TCollection_AsciiString(target.string().c_str()))) {
+               throw std::runtime_error("failed to write " + target.string());
+            }
+            ++stats.nWritten;
+         }
+         catch (const Standard_Failure& failure) {
+            job->error = failure.GetMessageString();
+            stats.failures.push_back(Describe(*job));
+         }
+         catch (const std::exception& ex) {
+            job->error = ex.what();
+            stats.failures.push_back(Describe(*job));
+         }
+      }
+   }
+   catch (...) {
+      // Keep draining so the producers can finish before the threads are joined
+      while (meshed.Pop()) {}
+      loader.join();
+      for (std::thread& mesher : meshers) mesher.join();
+      throw;
+   }
+
+   loader.join();
+   for (std::thread& mesher : meshers) mesher.join();
+
+   stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   std::cout << "Wrote " << stats.nWritten << " of " << stats.nParts << " thumbnails in " << stats.seconds << " s" << std::endl;
+   for (const std::string& failure : stats.failures) std::cerr << "Thumbnail failed: " << failure << std::endl;
+   return stats;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct ThumbnailOptions
+{
+   std::string inputDir;             // Searched recursively for IGES and STEP parts
+   std::string outputDir;            // One image per part: <stem>_<key>, the key hashing the full path and modification time
+   int width = 256;
+   int height = 256;
+   std::string imageExtension = "png"; // Any format Image_AlienPixMap can save: png, jpg, bmp...
+   int meshThreads = 0;              // 0 = one per core, less the loader and the renderer
+   std::size_t queueCapacity = 8;    // Parts buffered between stages
+   double relativeDeflection = 2e-3; // Mesh deflection as a fraction of the part diagonal
+};
+
+struct ThumbnailStats
+{
+   int nParts = 0;
+   int nWritten = 0;
+   double seconds = 0;
+   std::vector<std::string> failures; // "<part>: <reason>"
+};
+
+// Thumbnails for whole part libraries. Parts stream through load -> mesh -> render stages
+// connected by bounded queues, so reading, meshing and drawing overlap, and every image is
+// drawn by one offscreen GL context.
+class IGESThumbnails
+{
+public:
+   static ThumbnailStats Run(const ThumbnailOptions& options);
+};
@@ -0,0 +1,140 @@
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include "IGESTrace.h"
+
+namespace IGESTrace
+{
+   namespace
+   {
+      constexpr std::size_t kEventsPerThread = 1 << 16;
+
+      struct Event {
+         const char* name;
+         std::uint64_t startNs;
+         std::uint64_t endNs;
+      };
+
+      // One buffer per running thread. Only the owning thread writes events;
+      // readers see everything up to the published count. A finished thread's
+      // buffer keeps its spans and is handed to the next new thread, so threads
+      // that run one after another share a buffer (and a trace row) and the
+      // memory grows with the threads running at once, not with all threads ever.
+      struct ThreadBuffer {
+         std::uint32_t threadId = 0;
+         std::atomic<bool> inUse{ true };
+         std::atomic<std::size_t> count{ 0 };
+         std::atomic<std::size_t> dropped{ 0 };
+         ThreadBuffer* next = nullptr;
+         Event events[kEventsPerThread];
+      };
+
+      std::atomic<bool> gEnabled{ false };
+      std::atomic<ThreadBuffer*> gBuffers{ nullptr };
+      std::atomic<std::uint32_t> gNextThreadId{ 1 };
+      // Releases the thread's buffer when the thread exits
+      struct BufferLease {
+         ThreadBuffer* buffer = nullptr;
+         ~BufferLease() {
+            if (buffer != nullptr) buffer->inUse.store(false, std::memory_order_release);
+         }
+      };
+      thread_local BufferLease tLease;
+
+      ThreadBuffer* ThisThreadBuffer() {
+         ThreadBuffer*& tBuffer = tLease.buffer;
+         if (tBuffer == nullptr) {
+            for (ThreadBuffer* b = gBuffers.load(std::memory_order_acquire); b != nullptr; b = b->next) {
+               bool released = false;
+               if (b->inUse.compare_exchange_strong(released, true, std::memory_order_acquire)) {
+                  tBuffer = b;
+                  return tBuffer;
+               }
+            }
+            ThreadBuffer* buffer = new ThreadBuffer();
+            buffer->threadId = gNextThreadId.fetch_add(1, std::memory_order_relaxed);
+
+            // Lock-free push onto the global list of buffers
+            ThreadBuffer* head = gBuffers.load(std::memory_order_relaxed);
+            do {
+               buffer->next = head;
+            } while (!gBuffers.compare_exchange_weak(head, buffer, std::memory_order_release, std::memory_order_relaxed));
+            tBuffer = buffer;
+         }
+         return tBuffer;
+      }
+
+      void WriteEscaped(std::ofstream& out, const char* text) {
+         for (const char* c = text; *c != '\0'; ++c) {
+            if (*c == '"' || *c == '\\') out << '\\';
+            out << *c;
+         }
+      }
+   }
+
+#ifndef PROSMART_DISABLE_TRACING
+   bool IsEnabled() {
+      return gEnabled.load(std::memory_order_relaxed);
+   }
+#endif
+
+   void SetEnabled(bool enabled) {
+      gEnabled.store(enabled, std::memory_order_relaxed);
+   }
+
+   std::uint64_t NowNs() {
+      return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+         std::chrono::steady_clock::now().time_since_epoch()).count());
+   }
+
+   void Record(const char* name, std::uint64_t startNs, std::uint64_t endNs) {
+      ThreadBuffer* buffer = ThisThreadBuffer();
+      std::size_t n = buffer->count.load(std::memory_order_relaxed);
+      if (n >= kEventsPerThread) {
+         buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+         return;
+      }
+      buffer->events[n] = { name, startNs, endNs };
+      buffer->count.store(n + 1, std::memory_order_release);
+   }
+
+   void Clear() {
+      for (ThreadBuffer* b = gBuffers.load(std::memory_order_acquire); b != nullptr; b = b->next) {
+         b->count.store(0, std::memory_order_relaxed);
+         b->dropped.store(0, std::memory_order_relaxed);
+      }
+   }
+
+   void WriteChromeTrace(const std::string& filePath) {
+      std::ofstream out(filePath, std::ios::binary | std::ios::trunc);
+      if (!out) {
+         throw std::runtime_error("Failed to open trace file: " + filePath);
+      }
+
+      out << std::fixed << std::setprecision(3);
+      out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+      bool first = true;
+      std::size_t dropped = 0;
+      for (ThreadBuffer* b = gBuffers.load(std::memory_order_acquire); b != nullptr; b = b->next) {
+         std::size_t n = b->count.load(std::memory_order_acquire);
+         dropped += b->dropped.load(std::memory_order_relaxed);
+         for (std::size_t i = 0; i < n; ++i) {
+            const Event& e = b->events[i];
+            out << (first ? "\n" : ",\n") << "{\"name\":\"";
+            WriteEscaped(out, e.name);
+            // Chrome trace timestamps are in microseconds
+            out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->threadId
+               << ",\"ts\":" << (e.startNs / 1000.0)
+               << ",\"dur\":" << ((e.endNs - e.startNs) / 1000.0) << "}";
+            first = false;
+         }
+      }
+      out << "\n],\"otherData\":{\"droppedEvents\":" << dropped << "}}\n";
+
+      if (!out) {
+         throw std::runtime_error("Failed to write trace file: " + filePath);
+      }
+   }
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Scoped trace spans for the geometry hot paths.
+// Each thread records into its own fixed-size buffer without locking; the
+// collected spans can be written out as Chrome trace JSON (chrome://tracing,
+// ui.perfetto.dev). When tracing is disabled a span costs one call and a relaxed
+// load; the flag lives in IGESTrace.cpp so this header stays usable from /clr
+// sources. Define PROSMART_DISABLE_TRACING to compile the spans out completely,
+// which only holds for spans opened through the macros at the end of this file.
+namespace IGESTrace
+{
+#ifdef PROSMART_DISABLE_TRACING
+   constexpr bool IsEnabled() { return false; }
+#else
+   bool IsEnabled();
+#endif
+
+   void SetEnabled(bool enabled);
+
+   // Monotonic time in nanoseconds
+   std::uint64_t NowNs();
+
+   // Append a completed span to the calling thread's buffer
+   void Record(const char* name, std::uint64_t startNs, std::uint64_t endNs);
+
+   // Discard recorded spans. Call only while no traced work is running.
+   void Clear();
+
+   // Write every recorded span in Chrome trace event format
+   void WriteChromeTrace(const std::string& filePath);
+
+   // RAII span. The name must outlive the trace (use string literals).
+   class Scope
+   {
+   public:
+      explicit Scope(const char* name)
+         : mName(name), mStart(IsEnabled() ? NowNs() : 0) {}
+
+      ~Scope() { Stop(); }
+
+      // Close the span before the end of the enclosing block
+      void Stop() {
+         if (mStart != 0) {
+            Record(mName, mStart, NowNs());
+            mStart = 0;
+         }
+      }
+
+      Scope(const Scope&) = delete;
+      Scope& operator=(const Scope&) = delete;
+
+   private:
+      const char* mName;
+      std::uint64_t mStart;
+   };
+}
+
+#define PROSMART_TRACE_CONCAT_IMPL(a, b) a##b
+#define PROSMART_TRACE_CONCAT(a, b) PROSMART_TRACE_CONCAT_IMPL(a, b)
+
+// PROSMART_TRACE_SCOPE spans the rest of the block. PROSMART_TRACE_SPAN names its span
+// so that PROSMART_TRACE_STOP can close it earlier.
+#ifdef PROSMART_DISABLE_TRACING
+#define PROSMART_TRACE_SCOPE(name) ((void)0)
+#define PROSMART_TRACE_SPAN(var, name) ((void)0)
+#define PROSMART_TRACE_STOP(var) ((void)0)
+#else
+#define PROSMART_TRACE_SCOPE(name) IGESTrace::Scope PROSMART_TRACE_CONCAT(traceScope_, __LINE__)(name)
+#define PROSMART_TRACE_SPAN(var, name) IGESTrace::Scope var(name)
+#define PROSMART_TRACE_STOP(var) var.Stop()
+#endif
@@ -0,0 +1,67 @@
+#include <stdexcept>
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include "MappedFile.h"
+
+MappedFile::MappedFile(const std::string& filePath)
+{
+   HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+   if (file == INVALID_HANDLE_VALUE) {
+      throw std::runtime_error("Failed to open file: " + filePath);
+   }
+   mFile = file;
+
+   LARGE_INTEGER size;
+   if (!GetFileSizeEx(file, &size)) {
+      CloseHandle(file);
+      throw std::runtime_error("Failed to get the size of file: " + filePath);
+   }
+   mSize = static_cast<std::size_t>(size.QuadPart);
+
+   // Empty files cannot be mapped; they are exposed as a null, zero-length view
+   if (mSize == 0) return;
+
+   HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+   if (mapping == nullptr) {
+      CloseHandle(file);
+      throw std::runtime_error("Failed to map file: " + filePath);
+   }
+   mMapping = mapping;
+
+   mData = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+   if (mData == nullptr) {
+      CloseHandle(mapping);
+      CloseHandle(file);
+      throw std::runtime_error("Failed to map a view of file: " + filePath);
+   }
+}
+
+MappedFile::~MappedFile()
+{
+   if (mData != nullptr) UnmapViewOfFile(mData);
+   if (mMapping != nullptr) CloseHandle(static_cast<HANDLE>(mMapping));
+   if (mFile != nullptr) CloseHandle(static_cast<HANDLE>(mFile));
+}
+
+MemoryStreamBuf::MemoryStreamBuf(const char* data, std::size_t size)
+{
+   char* begin = const_cast<char*>(data); // Only the get area is used
+   setg(begin, begin, begin + size);
+}
+
+MemoryStreamBuf::pos_type MemoryStreamBuf::seekoff(off_type offset, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+   if (!(which & std::ios_base::in)) return pos_type(off_type(-1));
+   off_type base = dir == std::ios_base::beg ? 0 : dir == std::ios_base::cur ? gptr() - eback() : egptr() - eback();
+   off_type target = base + offset;
+   if (target < 0 || target > egptr() - eback()) return pos_type(off_type(-1));
+   setg(eback(), eback() + target, egptr());
+   return pos_type(target);
+}
+
+MemoryStreamBuf::pos_type MemoryStreamBuf::seekpos(pos_type position, std::ios_base::openmode which)
+{
+   return seekoff(off_type(position), std::ios_base::beg, which);
+}
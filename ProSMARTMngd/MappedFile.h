@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <streambuf>
+#include <string>
+
+// Read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+   explicit MappedFile(const std::string& filePath);
+   ~MappedFile();
+
+   MappedFile(const MappedFile&) = delete;
+   MappedFile& operator=(const MappedFile&) = delete;
+
+   const char* Data() const { return mData; }
+   std::size_t Size() const { return mSize; }
+
+private:
+   void* mFile = nullptr;    // HANDLE
+   void* mMapping = nullptr; // HANDLE
+   const char* mData = nullptr;
+   std::size_t mSize = 0;
+};
+
+// Seekable read-only stream buffer over bytes already in memory, typically a mapped file
+class MemoryStreamBuf : public std::streambuf
+{
+public:
+   MemoryStreamBuf(const char* data, std::size_t size);
+
+protected:
+   pos_type seekoff(off_type offset, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+   pos_type seekpos(pos_type position, std::ios_base::openmode which) override;
+};
@@ -0,0 +1,269 @@
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <BRep_Tool.hxx>
+#include <Poly_Triangulation.hxx>
+#include <TopExp.hxx>
+#include <TopLoc_Location.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Face.hxx>
+#include "MeshBVH.h"
+
+namespace
+{
+   const int kLeafSize = 4;
+
+   // Slab test; returns the entry distance through tNear
+   bool IntersectBox(const gp_XYZ& origin, const gp_XYZ& inverseDirection, const gp_XYZ& min, const gp_XYZ& max,
+      double maxT, double& tNear) {
+      double t0 = 0.0, t1 = maxT;
+      for (int axis = 1; axis <= 3; ++axis) {
+         double tA = (min.Coord(axis) - origin.Coord(axis)) * inverseDirection.Coord(axis);
+         double tB = (max.Coord(axis) - origin.Coord(axis)) * inverseDirection.Coord(axis);
+         if (tA > tB) std::swap(tA, tB);
+         // NaN from 0 * inf (ray in the slab plane) is treated as no constraint
+         if (tA == tA) t0 = std::max(t0, tA);
+         if (tB == tB) t1 = std::min(t1, tB);
+         if (t0 > t1) return false;
+      }
+      tNear = t0;
+      return true;
+   }
+
+   gp_XYZ Inverse(const gp_XYZ& direction) {
+      auto inv = [](double d) { return d != 0.0 ? 1.0 / d : (std::signbit(d) ? -1e300 : 1e300); };
+      return gp_XYZ(inv(direction.X()), inv(direction.Y()), inv(direction.Z()));
+   }
+}
+
+void MeshBVH::Build(const TopoDS_Shape& shape)
+{
+   Clear();
+   TopExp::MapShapes(shape, TopAbs_FACE, mFaces);
+
+   std::vector<Triangle> triangles;
+   for (int faceIndex = 1; faceIndex <= mFaces.Extent(); ++faceIndex) {
+      const TopoDS_Face& face = TopoDS::Face(mFaces(faceIndex));
+      TopLoc_Location location;
+      Handle(Poly_Triangulation) mesh = BRep_Tool::Triangulation(face, location);
+      if (mesh.IsNull()) continue;
+
+      const gp_Trsf& trsf = location.Transformation();
+      const bool reversed = face.Orientation() == TopAbs_REVERSED;
+      for (int i = 1; i <= mesh->NbTriangles(); ++i) {
+         int n1, n2, n3;
+         mesh->Triangle(i).Get(n1, n2, n3);
+         if (reversed) std::swap(n2, n3); // Keep the winding consistent with the face normal
+         Triangle triangle;
+         triangle.p0 = mesh->Node(n1).Transformed(trsf).XYZ();
+         triangle.p1 = mesh->Node(n2).Transformed(trsf).XYZ();
+         triangle.p2 = mesh->Node(n3).Transformed(trsf).XYZ();
+         triangle.face = faceIndex;
+         triangles.push_back(triangle);
+      }
+   }
+
+   TopTools_IndexedMapOfShape faces = mFaces; // Build(triangles) clears the map
+   Build(std::move(triangles));
+   mFaces = faces;
+}
+
+void MeshBVH::Build(std::vector<Triangle> triangles)
+{
+   Clear();
+   if (triangles.empty()) return;
+
+   std::vector<int> order(triangles.size());
+   std::vector<gp_XYZ> centroids(triangles.size());
+   for (size_t i = 0; i < triangles.size(); ++i) {
+      order[i] = static_cast<int>(i);
+      centroids[i] = (triangles[i].p0 + triangles[i].p1 + triangles[i].p2) / 3.0;
+   }
+   mTriangles = std::move(triangles);
+   mNodes.reserve(2 * mTriangles.size() / kLeafSize + 1);
+   BuildNode(order, centroids, 0, static_cast<int>(order.size()));
+
+   // Store the triangles in leaf order so every leaf is a contiguous range
+   std::vector<Triangle> sorted(mTriangles.size());
+   for (size_t i = 0; i < order.size(); ++i) sorted[i] = mTriangles[order[i]];
+   mTriangles = std::move(sorted);
+}
+
+int MeshBVH::BuildNode(std::vector<int>& order, std::vector<gp_XYZ>& centroids, int first, int count)
+{
+   const int index = static_cast<int>(mNodes.size());
+   mNodes.emplace_back();
+
+   gp_XYZ min(Precision::Infinite(), Precision::Infinite(), Precision::Infinite());
+   gp_XYZ max = -min;
+   gp_XYZ centroidMin = min, centroidMax = max;
+   for (int i = first; i < first + count; ++i) {
+      const Triangle& triangle = mTriangles[order[i]];
+      for (const gp_XYZ* p : { &triangle.p0, &triangle.p1, &triangle.p2 }) {
+         for (int axis = 1; axis <= 3; ++axis) {
+            min.SetCoord(axis, std::min(min.Coord(axis), p->Coord(axis)));
+            max.SetCoord(axis, std::max(max.Coord(axis), p->Coord(axis)));
+         }
+      }
+      for (int axis = 1; axis <= 3; ++axis) {
+         centroidMin.SetCoord(axis, std::min(centroidMin.Coord(axis), centroids[order[i]].Coord(axis)));
+         centroidMax.SetCoord(axis, std::max(centroidMax.Coord(axis), centroids[order[i]].Coord(axis)));
+      }
+   }
+   mNodes[index].min = min;
+   mNodes[index].max = max;
+
+   if (count <= kLeafSize) {
+      mNodes[index].first = first;
+      mNodes[index].count = count;
+      return index;
+   }
+
+   // Median split along the longest axis of the centroid bounds
+   const gp_XYZ extent = centroidMax - centroidMin;
+   int axis = 1;
+   if (extent.Y() > extent.Coord(axis)) axis = 2;
+   if (extent.Z() > extent.Coord(axis)) axis = 3;
+   const int half = count / 2;
+   std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count,
+      [&centroids, axis](int a, int b) { return centroids[a].Coord(axis) < centroids[b].Coord(axis); });
+
+   const int left = BuildNode(order, centroids, first, half);
+   const int right = BuildNode(order, centroids, first + half, count - half);
+   mNodes[index].left = left;
+   mNodes[index].right = right;
+   return index;
+}
+
+void MeshBVH::Clear()
+{
+   mFaces.Clear();
+   mTriangles.clear();
+   mNodes.clear();
+}
+
+bool MeshBVH::IntersectTriangle(const gp_XYZ& origin, const gp_XYZ& direction, const Triangle& triangle,
+   double& t, double& u, double& v)
+{
+   const double kEpsilon = 1e-12;
+   const gp_XYZ edge1 = triangle.p1 - triangle.p0;
+   const gp_XYZ edge2 = triangle.p2 - triangle.p0;
+   const gp_XYZ p = direction.Crossed(edge2);
+   const double determinant = edge1.Dot(p);
+   if (std::abs(determinant) < kEpsilon) return false; // Parallel to the triangle
+
+   const double inverse = 1.0 / determinant;
+   const gp_XYZ s = origin - triangle.p0;
+   u = s.Dot(p) * inverse;
+   if (u < 0.0 || u > 1.0) return false;
+
+   const gp_XYZ q = s.Crossed(edge1);
+   v = direction.Dot(q) * inverse;
+   if (v < 0.0 || u + v > 1.0) return false;
+
+   t = edge2.Dot(q) * inverse;
+   return true;
+}
+
+bool MeshBVH::Intersect(const gp_XYZ& origin, const gp_XYZ& direction, RayHit& hit, double maxT) const
+{
+   if (mNodes.empty()) return false;
+   const gp_XYZ inverseDirection = Inverse(direction);
+   double nearest = maxT;
+   bool found = false;
+
+   int stack[64];
+   int top = 0;
+   stack[top++] = 0;
+   while (top > 0) {
+      const Node& node = mNodes[stack[--top]];
+      double tNear;
+      if (!IntersectBox(origin, inverseDirection, node.min, node.max, nearest, tNear)) continue;
+
+      if (node.count > 0) {
+         for (int i = node.first; i < node.first + node.count; ++i) {
+            double t, u, v;
+            if (IntersectTriangle(origin, direction, mTriangles[i], t, u, v) && t >= 0.0 && t <= nearest) {
+               nearest = t;
+               hit.t = t;
+               hit.triangle = i;
+               hit.u = u;
+               hit.v = v;
+               found = true;
+            }
+         }
+      }
+      else {
+         // Visit the nearer child first so far boxes are culled by the closer hit
+         double tLeft = 0, tRight = 0;
+         const Node& left = mNodes[node.left];
+         const Node& right = mNodes[node.right];
+         const bool hitLeft = IntersectBox(origin, inverseDirection, left.min, left.max, nearest, tLeft);
+         const bool hitRight = IntersectBox(origin, inverseDirection, right.min, right.max, nearest, tRight);
+         if (hitLeft && hitRight) {
+            if (tLeft < tRight) { stack[top++] = node.right; stack[top++] = node.left; }
+            else { stack[top++] = node.left; stack[top++] = node.right; }
+         }
+         else if (hitLeft) stack[top++] = node.left;
+         else if (hitRight) stack[top++] = node.right;
+      }
+   }
+   return found;
+}
+
+int MeshBVH::CountCrossings(const gp_XYZ& origin, const gp_XYZ& direction) const
+{
+   if (mNodes.empty()) return 0;
+   const gp_XYZ inverseDirection = Inverse(direction);
+   int crossings = 0;
+
+   int stack[64];
+   int top = 0;
+   stack[top++] = 0;
+   while (top > 0) {
+      const Node& node = mNodes[stack[--top]];
+      double tNear;
+      if (!IntersectBox(origin, inverseDirection, node.min, node.max, Precision::Infinite(), tNear)) continue;
+      if (node.count > 0) {
+         for (int i = node.first; i < node.first + node.count; ++i) {
+            double t, u, v;
+            if (IntersectTriangle(origin, direction, mTriangles[i], t, u, v) && t > 0.0) ++crossings;
+         }
+      }
+      else {
+         stack[top++] = node.left;
+         stack[top++] = node.right;
+      }
+   }
+   return crossings;
+}
+
+std::vector<double> MeshBVH::Crossings(const gp_XYZ& origin, const gp_XYZ& direction) const
+{
+   std::vector<double> distances;
+   if (mNodes.empty()) return distances;
+   const gp_XYZ inverseDirection = Inverse(direction);
+
+   int stack[64];
+   int top = 0;
+   stack[top++] = 0;
+   while (top > 0) {
+      const Node& node = mNodes[stack[--top]];
+      double tNear;
+      if (!IntersectBox(origin, inverseDirection, node.min, node.max, Precision::Infinite(), tNear)) continue;
+      if (node.count > 0) {
+         for (int i = node.first; i < node.first + node.count; ++i) {
+            double t, u, v;
+            if (IntersectTriangle(origin, direction, mTriangles[i], t, u, v) && t > 0.0) distances.push_back(t);
+         }
+      }
+      else {
+         stack[top++] = node.left;
+         stack[top++] = node.right;
+      }
+   }
+   std::sort(distances.begin(), distances.end());
+   distances.erase(std::unique(distances.begin(), distances.end(),
+      [](double a, double b) { return b - a <= 1e-9 * (1.0 + b); }), distances.end());
+   return distances;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <vector>
+#include <gp_XYZ.hxx>
+#include <Precision.hxx>
+#include <TopoDS_Shape.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+
+// Bounding volume hierarchy over the triangulation stored on a shape's faces.
+// Built once per mesh and queried many times (picking, ray casts, mesh-vs-mesh tests).
+class MeshBVH
+{
+public:
+   struct Triangle
+   {
+      gp_XYZ p0, p1, p2;
+      int face = 0; // 1-based index into Faces()
+   };
+
+   // Leaves hold count > 0 triangles starting at first; inner nodes have children left/right
+   struct Node
+   {
+      gp_XYZ min, max;
+      int first = 0, count = 0;
+      int left = -1, right = -1;
+   };
+
+   struct RayHit
+   {
+      double t = 0;      // Distance along the (unit) direction
+      int triangle = -1; // Index into Triangles()
+      double u = 0, v = 0;
+   };
+
+   // Faces without a triangulation are skipped, so mesh the shape first
+   void Build(const TopoDS_Shape& shape);
+
+   // Build over triangles already in world coordinates
+   void Build(std::vector<Triangle> triangles);
+
+   void Clear();
+   bool IsEmpty() const { return mNodes.empty(); }
+
+   const TopTools_IndexedMapOfShape& Faces() const { return mFaces; }
+   const std::vector<Triangle>& Triangles() const { return mTriangles; }
+   const std::vector<Node>& Nodes() const { return mNodes; } // Root is node 0
+
+   // Nearest triangle hit with t in [0, maxT]
+   bool Intersect(const gp_XYZ& origin, const gp_XYZ& direction, RayHit& hit, double maxT = Precision::Infinite()) const;
+
+   // Triangles crossed for t > 0; odd means origin is inside a closed mesh
+   int CountCrossings(const gp_XYZ& origin, const gp_XYZ& direction) const;
+
+   // Distances t > 0 of every crossing, ascending; a hit on an edge shared by two
+   // triangles counts once
+   std::vector<double> Crossings(const gp_XYZ& origin, const gp_XYZ& direction) const;
+
+   // Moller-Trumbore ray/triangle test
+   static bool IntersectTriangle(const gp_XYZ& origin, const gp_XYZ& direction, const Triangle& triangle,
+      double& t, double& u, double& v);
+
+private:
+   int BuildNode(std::vector<int>& order, std::vector<gp_XYZ>& centroids, int first, int count);
+
+   TopTools_IndexedMapOfShape mFaces;
+   std::vector<Triangle> mTriangles;
+   std::vector<Node> mNodes;
+};
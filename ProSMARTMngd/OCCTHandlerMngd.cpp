@@ -1,109 +1,752 @@
 #include "ProSMARTMngd.h"
 #include <msclr/marshal_cppstd.h>
+#include <vcclr.h>
 #include "IGESHandler.h"
+#include "IGESBenchmark.h"
+#include "IGESJobService.h"
+#include "IGESThumbnails.h"
 #include "OCCTHandlerMngd.h"
 
 using namespace System;
 
 namespace IGESWrapper
 {
+   // Copy a native frame or file buffer into a managed byte array
+   static array<unsigned char>^ ToManagedArray(const std::vector<unsigned char>& data)
+   {
+      array<unsigned char>^ managedData = gcnew array<unsigned char>(static_cast<int>(data.size()));
+      if (!data.empty())
+      {
+         System::Runtime::InteropServices::Marshal::Copy(IntPtr(const_cast<unsigned char*>(data.data())), managedData, 0, managedData->Length);
+      }
+      return managedData;
+   }
+
+   // Completes a managed task from the native export thread, so no thread-pool thread
+   // blocks on the job
+   ref class ExportJobCompletion
+   {
+   private:
+      IGESExportJob* mJob;
+      System::Threading::Tasks::TaskCompletionSource<array<unsigned char>^>^ mSource;
+
+   public:
+      ExportJobCompletion(const IGESExportJob& job)
+         : mJob(new IGESExportJob(job)),
+           mSource(gcnew System::Threading::Tasks::TaskCompletionSource<array<unsigned char>^>(
+              System::Threading::Tasks::TaskCreationOptions::RunContinuationsAsynchronously))
+      {
+      }
+
+      ~ExportJobCompletion()
+      {
+         this->!ExportJobCompletion();
+      }
+
+      !ExportJobCompletion()
+      {
+         delete mJob;
+         mJob = nullptr;
+      }
+
+      property System::Threading::Tasks::Task<array<unsigned char>^>^ Task
+      {
+         System::Threading::Tasks::Task<array<unsigned char>^>^ get() { return mSource->Task; }
+      }
+
+      // Runs on the export thread; every failure ends up in the task
+      void Complete()
+      {
+         try
+         {
+            mSource->TrySetResult(ToManagedArray(mJob->Get()));
+         }
+         catch (const std::exception& ex)
+         {
+            // Convert native exception to managed exception
+            mSource->TrySetException(gcnew System::Exception(gcnew System::String(ex.what())));
+         }
+         catch (System::Exception^ ex)
+         {
+            mSource->TrySetException(ex);
+         }
+         catch (...)
+         {
+            mSource->TrySetException(gcnew System::Exception("The export failed with an unknown native error."));
+         }
+         finally
+         {
+            this->!ExportJobCompletion();
+         }
+      }
+   };
+
+   // Native callable the export job runs when it finishes
+   struct ExportJobCallback
+   {
+      gcroot<ExportJobCompletion^> completion;
+
+      void operator()() const
+      {
+         completion->Complete();
+      }
+   };
+
    IGESHandlerWrapper::IGESHandlerWrapper()
       : mIgesHandler(nullptr) // Initialize the shape pointer
    {
    }
 
-   IGESHandlerWrapper::~IGESHandlerWrapper()
+   IGESHandlerWrapper::~IGESHandlerWrapper()
+   {
+      // Clean up the unmanaged TopoDS_Shape instance
+      if (mIgesHandler != nullptr)
+      {
+         delete mIgesHandler;
+         mIgesHandler = nullptr;
+      }
+   }
+   void IGESHandlerWrapper::ZoomIn()
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+      mIgesHandler->PerformZoomAndRender(true);
+   }
+
+   void IGESHandlerWrapper::ZoomOut()
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+      mIgesHandler->PerformZoomAndRender(false);
+   }
+
+   void IGESHandlerWrapper::Initialize() {
+      if (mIgesHandler == nullptr) {
+         mIgesHandler = new IGESHandler();
+      }
+      /*else {
+          throw gcnew InvalidOperationException("Handler is already initialized.");
+      }*/
+   }
+
+   void IGESHandlerWrapper::LoadIGES(System::String^ filePath, int order)
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+
+      std::string stdFilePath = msclr::interop::marshal_as<std::string>(filePath);
+      mIgesHandler->LoadIGES(stdFilePath, order);
+   }
+
+   void IGESHandlerWrapper::SaveIGES(System::String^ filePath, int order)
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("No mIgesHandler is loaded.");
+      }
+
+      std::string stdFilePath = msclr::interop::marshal_as<std::string>(filePath);
+      mIgesHandler->SaveIGES(stdFilePath, order);
+   }
+
+   void IGESHandlerWrapper::LoadShape(System::String^ filePath, int order)
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+
+      try
+      {
+         std::string stdFilePath = msclr::interop::marshal_as<std::string>(filePath);
+         mIgesHandler->LoadShape(stdFilePath, order);
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
+   }
+
+   void IGESHandlerWrapper::SaveShape(System::String^ filePath, int order)
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+
+      try
+      {
+         std::string stdFilePath = msclr::interop::marshal_as<std::string>(filePath);
+         mIgesHandler->SaveShape(stdFilePath, order);
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
+   }
+
+   System::Threading::Tasks::Task<array<unsigned char>^>^ IGESHandlerWrapper::ExportToMemoryAsync(int order, ExportFormat format)
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+
+      try
+      {
+         ShapeFormat nativeFormat = ShapeFormat::IGES;
+         switch (format)
+         {
+         case ExportFormat::STEP: nativeFormat = ShapeFormat::STEP; break;
+         case ExportFormat::BRep: nativeFormat = ShapeFormat::BRep; break;
+         case ExportFormat::STL: nativeFormat = ShapeFormat::STL; break;
+         }
+         IGESExportJob job = mIgesHandler->ExportToMemoryAsync(order, nativeFormat);
+         ExportJobCompletion^ completion = gcnew ExportJobCompletion(job);
+         job.OnReady(ExportJobCallback{ completion });
+         return completion->Task;
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
+   }
+
+   array<System::String^>^ IGESHandlerWrapper::ExportAll(int order, array<System::String^>^ filePaths)
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+
+      try
+      {
+         std::vector<ExportTarget> targets;
+         for each (System::String^ filePath in filePaths)
+         {
+            ExportTarget target;
+            target.filePath = msclr::interop::marshal_as<std::string>(filePath);
+            target.format = IGESHandler::DetectFormat(target.filePath);
+            targets.push_back(target);
+         }
+
+         std::vector<ExportResult> results = mIgesHandler->ExportAll(order, targets);
+         array<System::String^>^ lines = gcnew array<System::String^>(static_cast<int>(results.size()));
+         for (int i = 0; i < lines->Length; ++i)
+         {
+            System::String^ path = gcnew System::String(results[i].filePath.c_str());
+            lines[i] = results[i].succeeded
+               ? System::String::Format("{0}: written in {1:F3} s", path, results[i].seconds)
+               : System::String::Format("{0}: failed, {1}", path, gcnew System::String(results[i].error.c_str()));
+         }
+         return lines;
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
+   }
+
+   array<System::String^>^ IGESHandlerWrapper::GetSlotIds()
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+
+      const std::vector<std::string> ids = mIgesHandler->GetSlotIds();
+      array<System::String^>^ result = gcnew array<System::String^>(static_cast<int>(ids.size()));
+      for (int i = 0; i < result->Length; ++i)
+      {
+         result[i] = gcnew System::String(ids[i].c_str());
+      }
+      return result;
+   }
+
+   System::String^ IGESHandlerWrapper::GetSlotReport(System::String^ id)
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+
+      try
+      {
+         const ShapeSlotInfo info = mIgesHandler->GetSlotInfo(msclr::interop::marshal_as<std::string>(id));
+         if (!info.loaded)
+         {
+            return id + ": empty";
+         }
+         return System::String::Format("{0}: {1}, generation {2}, box ({3:F3}, {4:F3}, {5:F3}) - ({6:F3}, {7:F3}, {8:F3})",
+            id, info.valid ? "valid" : "invalid", info.generation,
+            info.bounds[0], info.bounds[1], info.bounds[2], info.bounds[3], info.bounds[4], info.bounds[5]);
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
+   }
+
+   void IGESHandlerWrapper::LoadSlot(System::String^ id, System::String^ filePath)
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+
+      try
+      {
+         mIgesHandler->LoadSlot(msclr::interop::marshal_as<std::string>(id), msclr::interop::marshal_as<std::string>(filePath));
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
+   }
+
+   void IGESHandlerWrapper::RemoveSlot(System::String^ id)
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+
+      mIgesHandler->RemoveSlot(msclr::interop::marshal_as<std::string>(id));
+   }
+
+   void IGESHandlerWrapper::UnionSlots(array<System::String^>^ ids, System::String^ resultId)
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+
+      try
+      {
+         std::vector<std::string> nativeIds;
+         for each (System::String^ id in ids)
+         {
+            nativeIds.push_back(msclr::interop::marshal_as<std::string>(id));
+         }
+         mIgesHandler->UnionSlots(nativeIds, msclr::interop::marshal_as<std::string>(resultId));
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
+   }
+
+   System::String^ IGESHandlerWrapper::GetFormatTimingReport()
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+
+      System::Text::StringBuilder^ report = gcnew System::Text::StringBuilder();
+      for (const FormatTimings& timings : mIgesHandler->GetFormatTimings())
+      {
+         System::String^ name = timings.format == ShapeFormat::STEP ? "STEP" : timings.format == ShapeFormat::IGES ? "IGES" : "Other";
+         report->AppendLine(System::String::Format("{0}: {1} loads in {2:F3} s, {3} unions in {4:F3} s",
+            name, timings.loads, timings.loadSeconds, timings.unions, timings.unionSeconds));
+      }
+      return report->ToString();
+   }
+
+   System::String^ IGESHandlerWrapper::GetMassPropertiesReport(int order)
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+
+      try
+      {
+         return gcnew System::String(IGESMassProperties::Format(mIgesHandler->GetMassProperties(order)).c_str());
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
+   }
+
+   System::String^ IGESHandlerWrapper::GetInterferenceReport(int orderA, int orderB)
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+
+      try
+      {
+         return gcnew System::String(IGESInterference::Format(mIgesHandler->CheckInterference(orderA, orderB)).c_str());
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
+   }
+
+   array<SectionPolyline>^ IGESHandlerWrapper::Slice(int order, int axis, array<double>^ stations, bool fast)
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+
+      try
+      {
+         SliceOptions options;
+         options.axis = static_cast<SliceAxis>(axis);
+         options.fast = fast;
+         for each (double station in stations)
+         {
+            options.stations.push_back(station);
+         }
+
+         SliceReport report = mIgesHandler->Slice(order, options);
+         System::Collections::Generic::List<SectionPolyline>^ result = gcnew System::Collections::Generic::List<SectionPolyline>();
+         for (const SliceResult& slice : report.slices)
+         {
+            for (const SlicePolyline& polyline : slice.polylines)
+            {
+               SectionPolyline section;
+               section.Station = slice.station;
+               section.Closed = polyline.closed;
+               section.Points = gcnew array<double>(static_cast<int>(polyline.points.size() * 3));
+               for (int i = 0; i < static_cast<int>(polyline.points.size()); ++i)
+               {
+                  section.Points[3 * i] = polyline.points[i][0];
+                  section.Points[3 * i + 1] = polyline.points[i][1];
+                  section.Points[3 * i + 2] = polyline.points[i][2];
+               }
+               result->Add(section);
+            }
+         }
+         return result->ToArray();
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
+   }
+
+   void IGESHandlerWrapper::AlignToXYPlane(int order)
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("No mIgesHandler is loaded.");
+      }
+
+      mIgesHandler->AlignToXYPlane(order);
+   }
+
+   void IGESHandlerWrapper::SetFlipTest(FlipTestMode mode)
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+
+      mIgesHandler->SetFlipTest(static_cast<FlipTest>(mode));
+   }
+
+   void IGESHandlerWrapper::SetSpeculativeUnion(bool enable)
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+
+      mIgesHandler->SetSpeculativeUnion(enable);
+   }
+
+   void IGESHandlerWrapper::SetUnionMode(UnionAlgorithm mode)
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+
+      mIgesHandler->SetUnionMode(static_cast<UnionMode>(mode));
+   }
+
+   void IGESHandlerWrapper::AlignToXYPlane(int order, AlignMode mode)
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("No mIgesHandler is loaded.");
+      }
+
+      try
+      {
+         mIgesHandler->AlignToXYPlane(order, static_cast<AlignmentMode>(mode));
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
+   }
+   void IGESHandlerWrapper::Redraw() {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+      try
+      {
+         mIgesHandler->Redraw();
+      }
+      catch (const std::exception& ex) {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
+   }
+   void IGESHandlerWrapper::RotatePartBy180AboutZAxis(int order) {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+      try
+      {
+         mIgesHandler->RotatePartBy180AboutZAxis(order);
+         Redraw();
+      }
+      catch (const std::exception& ex) {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
+   }
+
+   array<unsigned char>^ IGESHandlerWrapper::RenderView(int width, int height, bool fused)
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+
+      try
+      {
+         return ToManagedArray(mIgesHandler->RenderView(width, height, fused));
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
+   }
+
+   array<unsigned char>^ IGESHandlerWrapper::ZoomView(double factor)
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+
+      try
+      {
+         return ToManagedArray(mIgesHandler->ZoomView(factor));
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
+   }
+
+   array<unsigned char>^ IGESHandlerWrapper::PanView(int dx, int dy)
    {
-      // Clean up the unmanaged TopoDS_Shape instance
-      if (mIgesHandler != nullptr)
+      if (mIgesHandler == nullptr)
       {
-         delete mIgesHandler;
-         mIgesHandler = nullptr;
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+
+      try
+      {
+         return ToManagedArray(mIgesHandler->PanView(dx, dy));
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
       }
    }
-   void IGESHandlerWrapper::ZoomIn()
+
+   array<unsigned char>^ IGESHandlerWrapper::OrbitView(double angleXDegrees, double angleYDegrees)
    {
       if (mIgesHandler == nullptr)
       {
          throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
       }
-      mIgesHandler->PerformZoomAndRender(true);
+
+      try
+      {
+         return ToManagedArray(mIgesHandler->OrbitView(angleXDegrees, angleYDegrees));
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
    }
 
-   void IGESHandlerWrapper::ZoomOut()
+   array<unsigned char>^ IGESHandlerWrapper::FitView()
    {
       if (mIgesHandler == nullptr)
       {
          throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
       }
-      mIgesHandler->PerformZoomAndRender(false);
+
+      try
+      {
+         return ToManagedArray(mIgesHandler->FitView());
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
    }
 
-   void IGESHandlerWrapper::Initialize() {
-      if (mIgesHandler == nullptr) {
-         mIgesHandler = new IGESHandler();
+   void IGESHandlerWrapper::BeginInteraction()
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
       }
-      /*else {
-          throw gcnew InvalidOperationException("Handler is already initialized.");
-      }*/
+      mIgesHandler->BeginInteraction();
    }
 
-   void IGESHandlerWrapper::LoadIGES(System::String^ filePath, int order)
+   array<unsigned char>^ IGESHandlerWrapper::EndInteraction()
    {
       if (mIgesHandler == nullptr)
       {
          throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
       }
 
-      std::string stdFilePath = msclr::interop::marshal_as<std::string>(filePath);
-      mIgesHandler->LoadIGES(stdFilePath, order);
+      try
+      {
+         return ToManagedArray(mIgesHandler->EndInteraction());
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
    }
 
-   void IGESHandlerWrapper::SaveIGES(System::String^ filePath, int order)
+   bool IGESHandlerWrapper::WaitForDetail(int timeoutMs)
    {
       if (mIgesHandler == nullptr)
       {
-         throw gcnew InvalidOperationException("No mIgesHandler is loaded.");
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
       }
 
-      std::string stdFilePath = msclr::interop::marshal_as<std::string>(filePath);
-      mIgesHandler->SaveIGES(stdFilePath, order);
+      try
+      {
+         return mIgesHandler->WaitForDetail(timeoutMs);
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
    }
 
-   void IGESHandlerWrapper::AlignToXYPlane(int order)
+   void IGESHandlerWrapper::PrepareView(bool fused)
    {
       if (mIgesHandler == nullptr)
       {
-         throw gcnew InvalidOperationException("No mIgesHandler is loaded.");
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
       }
 
-      mIgesHandler->AlignToXYPlane(order);
+      try
+      {
+         mIgesHandler->PrepareView(fused);
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
    }
-   void IGESHandlerWrapper::Redraw() {
+
+   PickInfo IGESHandlerWrapper::Pick(int x, int y)
+   {
       if (mIgesHandler == nullptr)
       {
          throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
       }
+
       try
       {
-         mIgesHandler->Redraw();
+         PickResult result = mIgesHandler->Pick(x, y);
+         PickInfo info;
+         info.Hit = result.hit;
+         info.Order = result.order;
+         info.Slot = gcnew System::String(result.slot.c_str());
+         info.Face = result.faceIndex;
+         info.Edge = result.edgeIndex;
+         info.X = result.x;
+         info.Y = result.y;
+         info.Z = result.z;
+         return info;
       }
-      catch (const std::exception& ex) {
+      catch (const std::exception& ex)
+      {
          // Convert native exception to managed exception
          throw gcnew System::Exception(gcnew System::String(ex.what()));
       }
    }
-   void IGESHandlerWrapper::RotatePartBy180AboutZAxis(int order) {
+
+   array<unsigned char>^ IGESHandlerWrapper::HighlightFace(int order, int face)
+   {
       if (mIgesHandler == nullptr)
       {
          throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
       }
+
       try
       {
-         mIgesHandler->RotatePartBy180AboutZAxis(order);
-         Redraw();
+         return ToManagedArray(mIgesHandler->HighlightFace(order, face));
       }
-      catch (const std::exception& ex) {
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
+   }
+
+   array<unsigned char>^ IGESHandlerWrapper::Hover(int x, int y)
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+
+      try
+      {
+         std::vector<unsigned char> frame = mIgesHandler->Hover(x, y);
+         return frame.empty() ? nullptr : ToManagedArray(frame);
+      }
+      catch (const std::exception& ex)
+      {
          // Convert native exception to managed exception
          throw gcnew System::Exception(gcnew System::String(ex.what()));
       }
@@ -206,6 +849,170 @@ namespace IGESWrapper
       }
    }
 
+   void IGESHandlerWrapper::SaveSession(System::String^ filePath)
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+
+      try
+      {
+         std::string stdFilePath = msclr::interop::marshal_as<std::string>(filePath);
+         mIgesHandler->SaveSession(stdFilePath);
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
+   }
+
+   void IGESHandlerWrapper::RestoreSession(System::String^ filePath)
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+
+      try
+      {
+         std::string stdFilePath = msclr::interop::marshal_as<std::string>(filePath);
+         mIgesHandler->RestoreSession(stdFilePath);
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
+   }
+
+   void IGESHandlerWrapper::EnableTracing(bool enable)
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+      mIgesHandler->EnableTracing(enable);
+   }
+
+   void IGESHandlerWrapper::WriteTrace(System::String^ filePath)
+   {
+      if (mIgesHandler == nullptr)
+      {
+         throw gcnew InvalidOperationException("Handler is not initialized. Call Initialize() first.");
+      }
+
+      try
+      {
+         std::string stdFilePath = msclr::interop::marshal_as<std::string>(filePath);
+         mIgesHandler->WriteTrace(stdFilePath);
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
+   }
+
+   void IGESHandlerWrapper::RunBenchmarks(System::String^ workDir, System::String^ resultsPath)
+   {
+      try
+      {
+         BenchmarkOptions options;
+         options.workDir = msclr::interop::marshal_as<std::string>(workDir);
+         options.resultsPath = msclr::interop::marshal_as<std::string>(resultsPath);
+         IGESBenchmark::Run(options);
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
+   }
+
+   int IGESHandlerWrapper::RunSmokeTest(System::String^ workDir)
+   {
+      try
+      {
+         BenchmarkOptions options;
+         options.workDir = msclr::interop::marshal_as<std::string>(workDir);
+         options.resultsPath = options.workDir + "/smoke.json";
+         options.faceCounts = { 100 };
+         options.repetitions = 1;
+         options.concurrentSessions = 1;
+         options.includeRender = false;
+         int failed = 0;
+         for (const BenchmarkSample& sample : IGESBenchmark::Run(options)) {
+            if (!sample.error.empty()) {
+               System::Console::Error->WriteLine(gcnew System::String((sample.part + " " + sample.operation + ": " + sample.error).c_str()));
+               ++failed;
+            }
+         }
+         return failed;
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
+   }
+
+   System::String^ IGESHandlerWrapper::RunThumbnails(System::String^ inputDir, System::String^ outputDir, int size)
+   {
+      try
+      {
+         ThumbnailOptions options;
+         options.inputDir = msclr::interop::marshal_as<std::string>(inputDir);
+         options.outputDir = msclr::interop::marshal_as<std::string>(outputDir);
+         options.width = options.height = size;
+         ThumbnailStats stats = IGESThumbnails::Run(options);
+         return System::String::Format("Wrote {0} of {1} thumbnails in {2:F1} s, {3} failed",
+            stats.nWritten, stats.nParts, stats.seconds, static_cast<int>(stats.failures.size()));
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
+   }
+
+   void IGESHandlerWrapper::RunJobService(int port, int queueCapacity, System::String^ shutdownToken)
+   {
+      try
+      {
+         JobServiceOptions options;
+         options.port = port;
+         options.queueCapacity = static_cast<std::size_t>(queueCapacity);
+         if (!System::String::IsNullOrEmpty(shutdownToken)) options.shutdownToken = msclr::interop::marshal_as<std::string>(shutdownToken);
+         IGESJobService::Serve(options);
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
+   }
+
+   System::String^ IGESHandlerWrapper::RunLoadGenerator(int port, System::String^ partPath, System::String^ outputDir, int clients, int workflowsPerClient)
+   {
+      try
+      {
+         LoadGeneratorOptions options;
+         options.port = port;
+         options.partPath = msclr::interop::marshal_as<std::string>(partPath);
+         options.outputDir = msclr::interop::marshal_as<std::string>(outputDir);
+         options.clients = clients;
+         options.workflowsPerClient = workflowsPerClient;
+         return gcnew System::String(IGESJobService::Format(IGESJobService::RunLoadGenerator(options)).c_str());
+      }
+      catch (const std::exception& ex)
+      {
+         // Convert native exception to managed exception
+         throw gcnew System::Exception(gcnew System::String(ex.what()));
+      }
+   }
+
 
    /*array<float, 2>^ IGESHandlerWrapper::ComputeThumbnailMatrix()
    {
@@ -6,6 +6,56 @@ class IGESHandler;
 
 namespace IGESWrapper
 {
+    // File formats the export paths can produce; STL is file-only
+    public enum class ExportFormat
+    {
+        IGES,
+        STEP,
+        BRep,
+        STL
+    };
+
+    // How AlignToXYPlane finds the part's axes; see AlignmentMode
+    public enum class AlignMode
+    {
+        AxisAligned,
+        OrientedBox,
+        PCA
+    };
+
+    // How AlignToXYPlane decides to turn the part over; see FlipTest
+    public enum class FlipTestMode
+    {
+        SingleRay,
+        RayGrid
+    };
+
+    // How UnionShapes unites the part with its mirrored copy; see UnionMode
+    public enum class UnionAlgorithm
+    {
+        Full,
+        SeamLocal
+    };
+
+    // One profile of a cross section; Points holds x, y, z triples
+    public value struct SectionPolyline
+    {
+        double Station;
+        bool Closed;
+        array<double>^ Points;
+    };
+
+    // Result of picking a pixel of the interactive view; indices are 1-based, 0 when nothing was hit
+    public value struct PickInfo
+    {
+        bool Hit;
+        int Order;
+        System::String^ Slot;
+        int Face;
+        int Edge;
+        double X, Y, Z;
+    };
+
     public ref class IGESHandlerWrapper
     {
     private:
@@ -30,17 +80,105 @@ namespace IGESWrapper
         // Save the IGES shape
         void SaveIGES(System::String^ filePath, int order);
 
+        // Load or save an IGES or STEP file, picking the format from the file
+        void LoadShape(System::String^ filePath, int order);
+        void SaveShape(System::String^ filePath, int order);
+
+        // Serialize a shape into memory on a background thread; the caller writes the bytes wherever it likes
+        System::Threading::Tasks::Task<array<unsigned char>^>^ ExportToMemoryAsync(int order, ExportFormat format);
+
+        // Write a shape to several files at once, the format of each taken from its extension.
+        // Returns one status line per file.
+        array<System::String^>^ ExportAll(int order, array<System::String^>^ filePaths);
+
+        // Named shape slots; orders 0..3 are the slots "left", "right", "fused" and "mirrored"
+        array<System::String^>^ GetSlotIds();
+        System::String^ GetSlotReport(System::String^ id);
+        void LoadSlot(System::String^ id, System::String^ filePath);
+        void RemoveSlot(System::String^ id);
+        void UnionSlots(array<System::String^>^ ids, System::String^ resultId);
+
+        // Import and union timings per source format, one line per format
+        System::String^ GetFormatTimingReport();
+
+        // Volume, area, center, topology counts and edge lengths of a shape, on one line
+        System::String^ GetMassPropertiesReport(int order);
+
+        // Whether two shapes overlap, touch or are apart, with gap, overlap volume and contact box
+        System::String^ GetInterferenceReport(int orderA, int orderB);
+
+        // Cross sections at the stations along axis 0 = X, 1 = Y, 2 = Z; fast intersects the mesh instead of the surfaces
+        array<SectionPolyline>^ Slice(int order, int axis, array<double>^ stations, bool fast);
+
         // Align the shape to the XY plane
         void AlignToXYPlane(int order);
+        void AlignToXYPlane(int order, AlignMode mode);
+        void SetFlipTest(FlipTestMode mode);
+
+        // Start the union in the background whenever the left part has been aligned
+        void SetSpeculativeUnion(bool enable);
+
+        void SetUnionMode(UnionAlgorithm mode);
 
         // Compute the thumbnail matrix for the shape
         //array<float, 2>^ ComputeThumbnailMatrix();
 
         array<unsigned char>^ DumpInputShapes(int width, int height);
         array<unsigned char>^ DumpFusedShape(int width, int height);
+
+        // Frames from the persistent offscreen view, top-down BGRA of the size passed to RenderView
+        array<unsigned char>^ RenderView(int width, int height, bool fused);
+        array<unsigned char>^ ZoomView(double factor);
+        array<unsigned char>^ PanView(int dx, int dy);
+        array<unsigned char>^ OrbitView(double angleXDegrees, double angleYDegrees);
+        array<unsigned char>^ FitView();
+
+        // Coarse levels of detail while the camera moves; EndInteraction returns the refined frame
+        void BeginInteraction();
+        array<unsigned char>^ EndInteraction();
+
+        // Wait for the finest levels of detail to finish meshing; false on timeout
+        bool WaitForDetail(int timeoutMs);
+
+        // Start meshing what RenderView will draw; safe to call off the UI thread
+        void PrepareView(bool fused);
+
+        // Face and edge under a pixel of the view, and a frame with that face highlighted (face 0 clears it)
+        PickInfo Pick(int x, int y);
+        array<unsigned char>^ HighlightFace(int order, int face);
+
+        // Overlay the face under the pointer; null when the frame on screen is still current
+        array<unsigned char>^ Hover(int x, int y);
+
         void RotatePartBy180AboutZAxis(int order);
         void Redraw();
         void SaveAsIGS(System::String^ filePath);
         void UnionShapes();
+
+        // Save or restore the parts, placements and union result as a binary snapshot
+        void SaveSession(System::String^ filePath);
+        void RestoreSession(System::String^ filePath);
+
+        // Enable or disable hot-path tracing
+        void EnableTracing(bool enable);
+
+        // Write the recorded trace as Chrome trace JSON
+        void WriteTrace(System::String^ filePath);
+
+        // Generate synthetic parts, time the pipeline on them and write JSON results
+        static void RunBenchmarks(System::String^ workDir, System::String^ resultsPath);
+
+        // Run the pipeline once on one small generated part; returns the number of failed operations
+        static int RunSmokeTest(System::String^ workDir);
+
+        // Render a thumbnail of every IGES/STEP part under inputDir into outputDir; returns a summary
+        static System::String^ RunThumbnails(System::String^ inputDir, System::String^ outputDir, int size);
+
+        // Serve geometry jobs on a localhost port until a client sends SHUTDOWN with the token;
+        // a null or empty token makes the service print a random one
+        static void RunJobService(int port, int queueCapacity, System::String^ shutdownToken);
+
+        // Drive a running job service with concurrent union workflows; returns a throughput summary
+        static System::String^ RunLoadGenerator(int port, System::String^ partPath, System::String^ outputDir, int clients, int workflowsPerClient);
     };
 }